@@ -0,0 +1,354 @@
+#include "gma3.h"
+#include "gma3_osc.h"
+#include <chrono>
+#include <new>
+#include <thread>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+Host benchmarks of the encoding, the framing and the update path of the controls,
+the results are written as CSV or with --json as JSON to stdout:
+name, scale (controls or payload bytes), iterations, ns/op and heap allocations/op
+*/
+
+#define BENCH_TIME_MS 200 // minimum measuring time of a benchmark
+#define BENCH_PASSES  20 // update passes for each number of controls
+#define BENCH_PORT    48300 // port of the simulated console on localhost
+#define BENCH_PAYLOAD 64 // size of the SLIP payloads
+
+typedef std::chrono::steady_clock benchClock;
+
+static uint64_t allocations = 0;
+static volatile uint32_t sink; // keeps the results alive
+static bool json = false;
+static bool firstResult = true;
+
+// every heap allocation is counted
+void* operator new(size_t size) {
+	allocations++;
+	void* memory = malloc(size ? size : 1);
+	if (!memory) throw std::bad_alloc();
+	return memory;
+	}
+
+void operator delete(void* memory) noexcept {
+	free(memory);
+	}
+
+void operator delete(void* memory, size_t) noexcept {
+	free(memory);
+	}
+
+static void result(const char* name, uint32_t scale, uint64_t iterations, double nanos, uint64_t allocs) {
+	if (json) {
+		printf("%s\n\t{\"name\": \"%s\", \"scale\": %u, \"iterations\": %llu, \"ns_per_op\": %.1f, \"allocs_per_op\": %.2f}",
+			firstResult ? "" : ",", name, (unsigned)scale, (unsigned long long)iterations, nanos / iterations, (double)allocs / iterations);
+		}
+	else {
+		printf("%s,%u,%llu,%.1f,%.2f\n", name, (unsigned)scale, (unsigned long long)iterations, nanos / iterations, (double)allocs / iterations);
+		}
+	firstResult = false;
+	fflush(stdout);
+	}
+
+// runs a function in growing batches for at least BENCH_TIME_MS
+template <typename Function>
+static void bench(const char* name, Function function, uint32_t scale = 1) {
+	uint64_t iterations = 0;
+	uint32_t batch = 1;
+	uint64_t allocs = allocations;
+	benchClock::time_point start = benchClock::now();
+	std::chrono::nanoseconds elapsed;
+	do {
+		for (uint32_t i = 0; i < batch; i++) {
+			sink = sink + function(i);
+			}
+		iterations += batch;
+		if (batch < 65536) batch *= 2;
+		elapsed = benchClock::now() - start;
+		} while (elapsed < std::chrono::milliseconds(BENCH_TIME_MS));
+	result(name, scale, iterations, elapsed.count(), allocations - allocs);
+	}
+
+// the original string codec, inserts and erases for each END and ESC byte
+static void baselineSlipEncode(string& msg) {
+	int length = msg.length();
+	for (int16_t i = length - 1; i >= 0; i--) {
+		if (msg[i] == END) {
+			msg[i] = ESC_END;
+			msg.insert(i, 1, ESC);
+			}
+		else if (msg[i] == ESC) {
+			msg[i] = ESC_ESC;
+			msg.insert(i, 1, ESC);
+			}
+		}
+	msg.insert(0, 1, END);
+	msg += END;
+	}
+
+static void baselineSlipDecode(string& msg) {
+	bool flagESC = false;
+	bool flagEND = false;
+	int length = msg.length();
+	for (int16_t i = length - 1; i >= 0; i--) {
+		if (msg[i] == END) {
+			msg.erase(i, 1);
+			}
+		if (msg[i] == ESC_END) {
+			flagEND = true;
+			}
+		if (msg[i] == ESC_ESC) {
+			flagESC = true;
+			}
+		if (msg[i] == ESC) {
+			if (flagEND) {
+				msg.erase(i + 1, 1);
+				msg[i] = END;
+				flagEND = false;
+				}
+			if (flagESC) {
+				msg.erase(i + 1, 1);
+				msg[i] = ESC;
+				flagESC = false;
+				}
+			}
+		}
+	}
+
+// the console discards everything
+static void drain(UDPSocket& console) {
+	char osc[OSC_MESSAGE_SIZE];
+	while (console.recvfrom(nullptr, osc, sizeof(osc)) > 0);
+	}
+
+// Fader::update() of a number of faders, each sends one UDP message per pass
+static void benchFaders(UDPSocket& console, uint32_t count) {
+	Fader** faders = new Fader*[count];
+	for (uint32_t i = 0; i < count; i++) {
+		faders[i] = new Fader(A0, 1, 101 + i);
+		}
+	double nanos = 0;
+	uint64_t allocs = 0;
+	// the first pass is not measured
+	for (uint32_t pass = 0; pass <= BENCH_PASSES; pass++) {
+		simulateAnalog(A0, (pass & 1) ? 40000 : 0);
+		std::this_thread::sleep_for(std::chrono::milliseconds(FADER_UPDATE_RATE_MS + 1));
+		uint64_t allocsStart = allocations;
+		benchClock::time_point start = benchClock::now();
+		for (uint32_t i = 0; i < count; i++) {
+			faders[i]->update();
+			}
+		std::chrono::nanoseconds elapsed = benchClock::now() - start;
+		if (pass) {
+			nanos += elapsed.count();
+			allocs += allocations - allocsStart;
+			}
+		drain(console);
+		}
+	result("fader_update_udp", count, (uint64_t)BENCH_PASSES * count, nanos, allocs);
+	for (uint32_t i = 0; i < count; i++) {
+		delete faders[i];
+		}
+	delete[] faders;
+	}
+
+int main(int argc, char* argv[]) {
+	json = (argc > 1) && (strcmp(argv[1], "--json") == 0);
+	if (json) printf("[");
+	else printf("name,scale,iterations,ns_per_op,allocs_per_op\n");
+
+	static char buffer[2 * OSC_MESSAGE_SIZE + 2];
+	const int32_t values[4] = {1, 2, 3, 4};
+	const float levels[4] = {0.25f, 0.5f, 0.75f, 1.0f};
+	const char blob[16] = {0};
+
+	// message() into a buffer
+	bench("message_int32", [&](uint32_t i) {
+		return message(buffer, sizeof(buffer), "/Page1/Fader201", (int32_t)i);
+		});
+	bench("message_float", [&](uint32_t i) {
+		return message(buffer, sizeof(buffer), "/Page1/Fader201", (float)i);
+		});
+	bench("message_string", [&](uint32_t) {
+		return message(buffer, sizeof(buffer), "/cmd", "Go+ Sequence 1");
+		});
+	bench("message_flag", [&](uint32_t) {
+		return message(buffer, sizeof(buffer), "/Page1/Key201", T);
+		});
+	bench("message_empty", [&](uint32_t) {
+		return message(buffer, sizeof(buffer), "/go");
+		});
+	bench("message_int32_array", [&](uint32_t) {
+		return message(buffer, sizeof(buffer), "/values", values, 4);
+		});
+	bench("message_float_array", [&](uint32_t) {
+		return message(buffer, sizeof(buffer), "/levels", levels, 4);
+		});
+	bench("message_blob", [&](uint32_t) {
+		return message(buffer, sizeof(buffer), "/data", blob, sizeof(blob));
+		});
+	bench("message_int32_tcp10", [&](uint32_t i) {
+		return message(buffer, sizeof(buffer), "/Page1/Fader201", (int32_t)i, TCP10);
+		});
+	bench("message_int32_tcp11", [&](uint32_t i) {
+		return message(buffer, sizeof(buffer), "/Page1/Fader201", (int32_t)i, TCP11);
+		});
+	bench("osc_message_ifs", [&](uint32_t i) {
+		return oscMessage(buffer, sizeof(buffer), UDP, "/mix", (int32_t)i, 0.5f, "name");
+		});
+
+	// compile time templates against the runtime encoding
+	constexpr auto fader201 = oscTemplate<int32_t>("/Page1/Fader201");
+	constexpr auto rgb = oscTemplate<float, float, float>("/light/rgb");
+	bench("template_int32", [&](uint32_t i) {
+		return fader201.message(buffer, sizeof(buffer), (int32_t)i);
+		});
+	bench("runtime_int32", [&](uint32_t i) {
+		return message(buffer, sizeof(buffer), "/Page1/Fader201", (int32_t)i);
+		});
+	bench("template_float3", [&](uint32_t i) {
+		return rgb.message(buffer, sizeof(buffer), (float)i, 0.5f, 1.0f);
+		});
+	bench("runtime_float3", [&](uint32_t i) {
+		return oscMessage(buffer, sizeof(buffer), UDP, "/light/rgb", (float)i, 0.5f, 1.0f);
+		});
+
+	// message() with strings
+	bench("string_message_int32", [&](uint32_t i) {
+		string osc = "/Page1/Fader201";
+		message(osc, (int32_t)i);
+		return osc.length();
+		});
+	bench("string_message_float", [&](uint32_t i) {
+		string osc = "/Page1/Fader201";
+		message(osc, (float)i);
+		return osc.length();
+		});
+	bench("string_message_string", [&](uint32_t) {
+		string osc = "/cmd";
+		message(osc, string("Go+ Sequence 1"));
+		return osc.length();
+		});
+	bench("string_message_flag", [&](uint32_t) {
+		string osc = "/Page1/Key201";
+		message(osc, T);
+		return osc.length();
+		});
+	bench("string_message_empty", [&](uint32_t) {
+		string osc = "/go";
+		message(osc);
+		return osc.length();
+		});
+
+	// SLIP framing, a plain payload and one of only END and ESC bytes
+	char plain[BENCH_PAYLOAD];
+	char adversarial[BENCH_PAYLOAD];
+	for (uint16_t i = 0; i < BENCH_PAYLOAD; i++) {
+		plain[i] = 'a' + i % 26;
+		adversarial[i] = (i & 1) ? (char)0xDB : (char)0xC0;
+		}
+	char encodedPlain[2 * BENCH_PAYLOAD + 2];
+	char encodedAdversarial[2 * BENCH_PAYLOAD + 2];
+	uint16_t plainLength = slipEncode(plain, BENCH_PAYLOAD, encodedPlain, sizeof(encodedPlain));
+	uint16_t adversarialLength = slipEncode(adversarial, BENCH_PAYLOAD, encodedAdversarial, sizeof(encodedAdversarial));
+	bench("slip_encode_plain", [&](uint32_t) {
+		return slipEncode(plain, BENCH_PAYLOAD, buffer, sizeof(buffer));
+		});
+	bench("slip_encode_adversarial", [&](uint32_t) {
+		return slipEncode(adversarial, BENCH_PAYLOAD, buffer, sizeof(buffer));
+		});
+	bench("string_slip_encode_adversarial", [&](uint32_t) {
+		string msg(adversarial, BENCH_PAYLOAD);
+		slipEncode(msg);
+		return msg.length();
+		});
+	bench("slip_decode_plain", [&](uint32_t) {
+		return slipDecode(encodedPlain, plainLength, buffer, sizeof(buffer));
+		});
+	bench("slip_decode_adversarial", [&](uint32_t) {
+		return slipDecode(encodedAdversarial, adversarialLength, buffer, sizeof(buffer));
+		});
+	bench("string_slip_decode_adversarial", [&](uint32_t) {
+		string msg(encodedAdversarial, adversarialLength);
+		slipDecode(msg);
+		return msg.length();
+		});
+	bench("slip_stream_adversarial", [&](uint32_t) {
+		// TCP chunks of 7 bytes
+		SlipDecoder decoder(buffer, sizeof(buffer));
+		uint32_t frames = 0;
+		for (uint16_t position = 0; position < adversarialLength; ) {
+			uint16_t chunk = (adversarialLength - position < 7) ? adversarialLength - position : 7;
+			position += decoder.decode(encodedAdversarial + position, chunk);
+			if (decoder.available()) frames += decoder.length();
+			}
+		return frames;
+		});
+
+	// the string codec against the original one on multi KB adversarial payloads,
+	// the int16_t index of the original limits the encoded payloads to 32 KB
+	const uint32_t payloads[] = {1024, 4096, 8192};
+	for (uint32_t payload : payloads) {
+		string raw(payload, END);
+		for (uint32_t i = 1; i < payload; i += 2) {
+			raw[i] = ESC;
+			}
+		string framed = raw;
+		slipEncode(framed);
+		string check = raw;
+		baselineSlipEncode(check);
+		if (check != framed) printf("# baseline SLIP encoding differs at %u bytes\n", (unsigned)payload);
+		bench("baseline_slip_encode_adversarial", [&](uint32_t) {
+			string msg = raw;
+			baselineSlipEncode(msg);
+			return msg.length();
+			}, payload);
+		bench("string_slip_encode_adversarial", [&](uint32_t) {
+			string msg = raw;
+			slipEncode(msg);
+			return msg.length();
+			}, payload);
+		bench("baseline_slip_decode_adversarial", [&](uint32_t) {
+			string msg = framed;
+			baselineSlipDecode(msg);
+			return msg.length();
+			}, payload);
+		bench("string_slip_decode_adversarial", [&](uint32_t) {
+			string msg = framed;
+			slipDecode(msg);
+			return msg.length();
+			}, payload);
+		}
+
+	// TCP10 length prefix
+	uint16_t faderLength = message(buffer, sizeof(buffer), "/Page1/Fader201", (int32_t)50);
+	char fader[OSC_MESSAGE_SIZE];
+	memcpy(fader, buffer, faderLength);
+	bench("tcp_encode", [&](uint32_t) {
+		memcpy(buffer, fader, faderLength);
+		return tcpEncode(buffer, faderLength, sizeof(buffer));
+		});
+	bench("string_tcp_encode", [&](uint32_t) {
+		string msg(fader, faderLength);
+		tcpEncode(msg);
+		return msg.length();
+		});
+
+	// the update path of the controls to a console on localhost
+	UDPSocket console;
+	console.open(nullptr);
+	console.bind(BENCH_PORT);
+	console.set_blocking(false);
+	uint8_t localhost[] = {127, 0, 0, 1};
+	interfaceUDP(localhost, BENCH_PORT);
+	const uint32_t counts[] = {1, 10, 100, 1000};
+	for (uint32_t count : counts) {
+		benchFaders(console, count);
+		}
+
+	if (json) printf("\n]\n");
+	return 0;
+	}
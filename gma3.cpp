@@ -1,14 +1,11 @@
 #include "gma3.h"
-#include "DigitalIn.h"
-#include "PinNames.h"
-#include "SocketAddress.h"
-#include "TCPSocket.h"
-#include "UDPSocket.h"
 
 EthernetInterface eth;
 UDPSocket udp;
-TCPSocket tcp;
-TCPSocket tcpExtern;
+UDPSocket udpReceive; // non blocking, so the sends of udp stay blocking
+TcpConnection tcp;
+TcpConnection tcpExtern[TCP_CONNECTIONS];
+Mutex tcpExternMutex; // slots of tcpExtern are searched and assigned by the loop and the network thread
 SocketAddress GMA3_UDP;
 SocketAddress GMA3_TCP;
 
@@ -17,6 +14,106 @@ string pageName = "Page"; // Page name
 string faderName = "Fader"; // Fader name
 string executorKnobName = "Encoder"; // ExecutorKnob name
 string keyName = "Key"; // Key name
+uint32_t nameGeneration = 1; // changes with every name change, cached packets are rebuild then
+
+const uint16_t FRAME_SIZE = 2 * (OSC_MESSAGE_SIZE > BUNDLE_TCP_SIZE ? OSC_MESSAGE_SIZE : BUNDLE_TCP_SIZE) + 2;
+char frameBuffer[FRAME_SIZE]; // TCP10 and TCP11 framing
+
+const int32_t FADER_MIN = 8 << 6; // 16 bit fader limits
+const int32_t FADER_MAX = (1015 << 6) | 63;
+
+char udpBundleBuffer[BUNDLE_SIZE];
+char tcpBundleBuffer[BUNDLE_TCP_SIZE];
+OscBundle udpBundle(udpBundleBuffer, sizeof(udpBundleBuffer));
+OscBundle tcpBundle(tcpBundleBuffer, sizeof(tcpBundleBuffer));
+protocol_t tcpBundleProtocol = TCP;
+bool bundling = false;
+uint32_t bundleDeadline = BUNDLE_DEADLINE_MS * 1000;
+
+Control* controlsPending = nullptr; // new controls, scheduled with the next updateControls()
+Control* controlsWheel[SCHEDULER_SLOTS]; // timing wheel, a slot holds the controls due at tick % SCHEDULER_SLOTS
+uint32_t wheelTick = 0;
+uint32_t wheelTime = 0;
+bool wheelStarted = false;
+Control* controlsAll = nullptr; // all controls for the diagnostics
+PageBank* pageBanks = nullptr; // all page banks, rendered again when a name changes
+void renderPageBanks();
+
+OscQueue outQueue; // messages of the controls for the network thread
+Thread* networkTask = nullptr;
+Semaphore networkSignal(0);
+volatile bool networkRunning = false;
+volatile bool coalescing = false;
+uint16_t coalesceInterval = COALESCE_INTERVAL_MS;
+uint32_t coalesceTime = 0;
+
+#if GMA3_PROFILE
+Profile profileLoop; // one pass of updateControls()
+Profile profilePeriod; // time between two passes
+Profile profileUdp; // UDP deliveries of the controls, only used by the sending thread
+Profile profileTcp; // TCP deliveries of the controls, only used by the sending thread
+SocketAddress profileAddress;
+bool profiling = false;
+volatile bool profileRequest = false; // the network thread reports the deliveries
+uint16_t profileInterval = PROFILE_INTERVAL_MS;
+uint32_t profileTime = 0;
+uint32_t profileLast = 0; // start of the last pass in cycles
+void profileSend();
+static void profileDeliveries();
+
+// adds the lifetime of the scope to a profile
+class ProfileScope {
+	public:
+		ProfileScope(Profile& profile) : profile(profile), start(halCycles()) {}
+		~ProfileScope() {
+			profile.add(halCycles() - start);
+			}
+	private:
+		Profile& profile;
+		uint32_t start;
+	};
+
+#define PROFILE_SCOPE(profile) ProfileScope profileScope(profile)
+#else
+#define PROFILE_SCOPE(profile)
+#endif
+
+struct Destination {
+	SocketAddress address;
+	protocol_t protocol;
+	uint16_t rate; // messages/s, 0 is unlimited
+	uint64_t tokens; // token bucket in 1/1000000 messages
+	uint64_t capacity;
+	uint32_t refillTime;
+	uint32_t limited;
+	uint8_t shares; // OscButtons using the entry, 0 for an entry of destination()
+	bool used;
+	};
+
+Destination destinations[DESTINATIONS];
+volatile uint8_t destinationTargets = 0; // target bits of the used destinations
+Mutex destinationMutex;
+
+enum {
+	SLOT_EMPTY,
+	SLOT_READY,
+	SLOT_BUSY,
+	SLOT_DROPPED,
+	SLOT_WRITING // the producer replaces the message in place
+	};
+
+struct OscHandler {
+	const char* pattern;
+	osc_callback_t callback;
+	void* context;
+	};
+
+OscHandler oscHandlers[OSC_HANDLERS]; // sorted by pattern
+uint8_t oscHandlerCount = 0;
+char receiveBuffer[OSC_RECEIVE_SIZE];
+char tcpFrameBuffer[OSC_RECEIVE_SIZE]; // shared by the TCP10 and TCP11 decoder
+SlipDecoder slipDecoder(tcpFrameBuffer, sizeof(tcpFrameBuffer));
+TcpDecoder tcpDecoder(tcpFrameBuffer, sizeof(tcpFrameBuffer));
 
 void interfaceETH(uint8_t localIP[], uint8_t subnet[]) {
 	SocketAddress LOCAL_IP(localIP, NSAPI_IPv4);
@@ -27,495 +124,2697 @@ void interfaceETH(uint8_t localIP[], uint8_t subnet[]) {
 	eth.connect();
 }
 
-void interfaceUDP(uint8_t gma3IP[], uint16_t gma3UdpPort) {
+void interfaceUDP(uint8_t gma3IP[], uint16_t gma3UdpPort, uint16_t localUdpPort) {
 	GMA3_UDP.set_ip_bytes(gma3IP, NSAPI_IPv4);
 	GMA3_UDP.set_port(gma3UdpPort);
 	udp.open(&eth);
+	if (localUdpPort) {
+		udpReceive.open(&eth);
+		udpReceive.bind(localUdpPort);
+		udpReceive.set_blocking(false);
+		}
 	}
 
 void interfaceTCP(uint8_t gma3IP[], uint16_t gma3TcpPort) {
 	GMA3_TCP.set_ip_bytes(gma3IP, NSAPI_IPv4);
 	GMA3_TCP.set_port(gma3TcpPort);
-	tcp.set_blocking(false);
-	tcp.set_timeout(50);
+	tcp.begin(&eth, GMA3_TCP);
+	}
+
+bool sendUDP(string& msg) {
+	return sendUDP(msg.data(), msg.length());
+	}
+
+bool sendUDP(string& msg, SocketAddress address) {
+	return sendUDP(msg.data(), msg.length(), address);
+	}
+
+bool sendUDP(const char* msg, uint16_t length) {
+	return udp.sendto(GMA3_UDP, msg, length) >= 0;
+	}
+
+bool sendUDP(const char* msg, uint16_t length, SocketAddress address) {
+	return udp.sendto(address, msg, length) >= 0;
+	}
+
+bool sendTCP(string& msg) {
+	return sendTCP(msg.data(), msg.length());
+	}
+
+bool sendTCP(string& msg, SocketAddress address) {
+	return sendTCP(msg.data(), msg.length(), address);
+	}
+
+bool sendTCP(const char* msg, uint16_t length) {
+	return tcp.send(msg, length);
+	}
+
+bool sendTCP(const char* msg, uint16_t length, SocketAddress address) {
+	ScopedLock<Mutex> lock(tcpExternMutex);
+	TcpConnection* connection = nullptr;
+	for (uint8_t i = 0; i < TCP_CONNECTIONS; i++) {
+		if (tcpExtern[i].assigned(address)) {
+			connection = &tcpExtern[i];
+			break;
+			}
+		}
+	if (connection == nullptr) {
+		for (uint8_t i = 0; i < TCP_CONNECTIONS; i++) {
+			if (!tcpExtern[i].assigned()) {
+				connection = &tcpExtern[i];
+				connection->begin(&eth, address);
+				break;
+				}
+			}
+		}
+	if (connection == nullptr) return false;
+	return connection->send(msg, length);
+	}
+
+/**
+ * @brief free the extern TCP connection to an address
+ * 
+ */
+static void releaseTCP(const SocketAddress& address) {
+	ScopedLock<Mutex> lock(tcpExternMutex);
+	for (uint8_t i = 0; i < TCP_CONNECTIONS; i++) {
+		if (tcpExtern[i].assigned(address)) tcpExtern[i].end();
+		}
+	}
+
+void updateTCP() {
+	tcp.update();
+	for (uint8_t i = 0; i < TCP_CONNECTIONS; i++) {
+		tcpExtern[i].update();
+		}
+	}
+
+connection_t stateTCP() {
+	return tcp.state();
+	}
+
+uint32_t droppedTCP() {
+	return tcp.dropped();
+	}
+
+OscBundle::OscBundle(char* buffer, uint16_t size) {
+	this->buffer = buffer;
+	this->size = size;
+	position = 0;
+	messages = 0;
+	startTime = 0;
+	}
+
+bool OscBundle::add(const char* msg, uint16_t length) {
+	if (messages == 0) {
+		if (size < 16) return false;
+		// bundle tag and immediate timetag
+		memcpy(buffer, "#bundle\0\0\0\0\0\0\0\0\1", 16);
+		position = 16;
+		startTime = halMicros();
+		}
+	if ((uint32_t)position + 4 + length > size) return false;
+	oscStore32(buffer + position, length);
+	position += 4;
+	memcpy(buffer + position, msg, length);
+	position += length;
+	messages++;
+	return true;
+	}
+
+void OscBundle::clear() {
+	position = 0;
+	messages = 0;
+	}
+
+uint16_t OscBundle::count() {
+	return messages;
+	}
+
+uint32_t OscBundle::age() {
+	if (messages == 0) return 0;
+	return halMicros() - startTime;
+	}
+
+const char* OscBundle::data() {
+	if (messages == 1) return buffer + 20;
+	return buffer;
+	}
+
+uint16_t OscBundle::length() {
+	if (messages == 0) return 0;
+	if (messages == 1) return position - 20;
+	return position;
+	}
+
+/**
+ * @brief binary search of a handler
+ * 
+ * @param pattern OSC address
+ * @param found true if the handler exists
+ * @return uint8_t index of the handler or the insert position
+ */
+static uint8_t findOscHandler(const char* pattern, bool& found) {
+	uint8_t low = 0;
+	uint8_t high = oscHandlerCount;
+	found = false;
+	while (low < high) {
+		uint8_t middle = (low + high) / 2;
+		int compare = strcmp(oscHandlers[middle].pattern, pattern);
+		if (compare == 0) {
+			found = true;
+			return middle;
+			}
+		if (compare < 0) low = middle + 1;
+		else high = middle;
+		}
+	return low;
+	}
+
+bool oscHandler(const char* pattern, osc_callback_t callback, void* context) {
+	bool found;
+	uint8_t index = findOscHandler(pattern, found);
+	if (!found) {
+		if (oscHandlerCount >= OSC_HANDLERS) return false;
+		memmove(&oscHandlers[index + 1], &oscHandlers[index], (oscHandlerCount - index) * sizeof(OscHandler));
+		oscHandlerCount++;
+		}
+	oscHandlers[index].pattern = pattern;
+	oscHandlers[index].callback = callback;
+	oscHandlers[index].context = context;
+	return true;
+	}
+
+void removeOscHandler(const char* pattern) {
+	bool found;
+	uint8_t index = findOscHandler(pattern, found);
+	if (!found) return;
+	oscHandlerCount--;
+	memmove(&oscHandlers[index], &oscHandlers[index + 1], (oscHandlerCount - index) * sizeof(OscHandler));
+	}
+
+void dispatch(const char* msg, uint16_t length) {
+	if ((length >= 16) && (memcmp(msg, "#bundle", 8) == 0)) {
+		// bundle elements, the timetag is ignored
+		uint16_t position = 16;
+		while (length - position >= 4) {
+			uint32_t size = oscLoad32(msg + position);
+			position += 4;
+			if (size > (uint32_t)(length - position)) return;
+			dispatch(msg + position, size);
+			position += size;
+			}
+		return;
+		}
+	OscReader reader;
+	if (!reader.parse(msg, length)) return;
+	bool found;
+	uint8_t index = findOscHandler(reader.address(), found);
+	if (found) oscHandlers[index].callback(reader, oscHandlers[index].context);
+	}
+
+void receiveUDP() {
+	while (true) {
+		nsapi_size_or_error_t length = udpReceive.recvfrom(nullptr, receiveBuffer, sizeof(receiveBuffer));
+		if (length <= 0) return;
+		dispatch(receiveBuffer, length);
+		}
+	}
+
+void receiveTCP(protocol_t protocol) {
+	while (true) {
+		uint16_t length = tcp.receive(receiveBuffer, sizeof(receiveBuffer));
+		if (length == 0) return;
+		const char* data = receiveBuffer;
+		while (length > 0) {
+			uint16_t used;
+			switch (protocol) {
+				case TCP10:
+					used = tcpDecoder.decode(data, length);
+					if (tcpDecoder.available()) dispatch(tcpDecoder.data(), tcpDecoder.length());
+					break;
+				case TCP11:
+					used = slipDecoder.decode(data, length);
+					if (slipDecoder.available()) dispatch(slipDecoder.data(), slipDecoder.length());
+					break;
+				default:
+					// without framing every received chunk is taken as one message
+					dispatch(data, length);
+					used = length;
+					break;
+				}
+			data += used;
+			length -= used;
+			}
+		}
+	}
+
+/**
+ * @brief length of an OSC string including the padding
+ * 
+ * @return uint16_t length, 0 if the string isn't terminated inside the message
+ */
+static uint16_t oscStringLength(const char* data, uint16_t length) {
+	const char* end = (const char*)memchr(data, '\0', length);
+	if (end == nullptr) return 0;
+	uint16_t size = ((end - data) / 4 + 1) * 4;
+	return (size > length) ? 0 : size;
+	}
+
+bool OscReader::parse(const char* msg, uint16_t length) {
+	pattern = "";
+	typeTags = "";
+	arguments = 0;
+	if ((length < 4) || (msg[0] != '/')) return false;
+	uint16_t position = oscStringLength(msg, length);
+	if (position == 0) return false;
+	pattern = msg;
+	// messages without type tags have no arguments
+	if ((position == length) || (msg[position] != ',')) return true;
+	uint16_t size = oscStringLength(msg + position, length - position);
+	if (size == 0) return false;
+	typeTags = msg + position + 1;
+	position += size;
+	for (const char* tag = typeTags; *tag != '\0'; tag++) {
+		if (arguments >= OSC_ARGUMENTS) return false;
+		values[arguments] = msg + position;
+		uint32_t argument = 0;
+		switch (*tag) {
+			case 'i':
+			case 'f':
+				argument = 4;
+				break;
+			case 'h':
+			case 'd':
+				argument = 8;
+				break;
+			case 's':
+				argument = oscStringLength(msg + position, length - position);
+				if (argument == 0) return false;
+				break;
+			case 'b': {
+				if (length - position < 4) return false;
+				// check the raw size first, the padding of a huge size would wrap around
+				uint32_t blob = oscLoad32(msg + position);
+				if (blob > (uint32_t)(length - position - 4)) return false;
+				argument = 4 + ((blob + 3) & ~3u);
+				break;
+				}
+			case 'T':
+			case 'F':
+			case 'N':
+			case 'I':
+				break;
+			default:
+				return false;
+			}
+		if (argument > (uint32_t)(length - position)) return false;
+		position += argument;
+		arguments++;
+		}
+	return true;
+	}
+
+const char* OscReader::address() {
+	return pattern;
+	}
+
+const char* OscReader::tags() {
+	return typeTags;
+	}
+
+uint8_t OscReader::count() {
+	return arguments;
+	}
+
+char OscReader::type(uint8_t index) {
+	if (index >= arguments) return '\0';
+	return typeTags[index];
+	}
+
+int32_t OscReader::getInt(uint8_t index) {
+	switch (type(index)) {
+		case 'i':
+			return oscLoad32(values[index]);
+		case 'h':
+			return getInt64(index);
+		case 'f':
+		case 'd':
+			return (int32_t)(getFloat(index) + (getFloat(index) < 0 ? -0.5f : 0.5f));
+		case 'T':
+			return 1;
+		default:
+			return 0;
+		}
+	}
+
+float OscReader::getFloat(uint8_t index) {
+	uint32_t data;
+	float value;
+	switch (type(index)) {
+		case 'f':
+			data = oscLoad32(values[index]);
+			memcpy(&value, &data, sizeof(value));
+			return value;
+		case 'i':
+			return (int32_t)oscLoad32(values[index]);
+		case 'h':
+		case 'd':
+			return getDouble(index);
+		case 'T':
+			return 1.0f;
+		default:
+			return 0.0f;
+		}
+	}
+
+int64_t OscReader::getInt64(uint8_t index) {
+	switch (type(index)) {
+		case 'h':
+			return (int64_t)(((uint64_t)oscLoad32(values[index]) << 32) | oscLoad32(values[index] + 4));
+		case 'd':
+			return (int64_t)(getDouble(index) + (getDouble(index) < 0 ? -0.5 : 0.5));
+		default:
+			return getInt(index);
+		}
+	}
+
+double OscReader::getDouble(uint8_t index) {
+	uint64_t data;
+	double value;
+	switch (type(index)) {
+		case 'd':
+			data = ((uint64_t)oscLoad32(values[index]) << 32) | oscLoad32(values[index] + 4);
+			memcpy(&value, &data, sizeof(value));
+			return value;
+		case 'h':
+			return getInt64(index);
+		default:
+			return getFloat(index);
+		}
+	}
+
+const char* OscReader::getString(uint8_t index) {
+	if (type(index) != 's') return nullptr;
+	return values[index];
+	}
+
+bool OscReader::getBool(uint8_t index) {
+	switch (type(index)) {
+		case 'T':
+			return true;
+		case 'i':
+		case 'f':
+		case 'h':
+		case 'd':
+			return getDouble(index) != 0.0;
+		default:
+			return false;
+		}
+	}
+
+const char* OscReader::getBlob(uint8_t index, uint16_t& length) {
+	length = 0;
+	if (type(index) != 'b') return nullptr;
+	length = oscLoad32(values[index]);
+	return values[index] + 4;
 	}
 
-void sendUDP(string& msg) {
-	udp.sendto(GMA3_UDP, msg.data(), msg.length());
+TcpConnection::TcpConnection() {
+	interface = nullptr;
+	status = DISCONNECTED;
+	retryTime = 0;
+	connectTime = 0;
+	backoff = TCP_BACKOFF_MIN_MS;
+	queued = 0;
+	sent = 0;
+	drops = 0;
 	}
 
-void sendUDP(string& msg, SocketAddress address) {
-	udp.sendto(address, msg.data(), msg.length());
+void TcpConnection::begin(NetworkInterface* interface, SocketAddress address) {
+	ScopedLock<Mutex> lock(mutex);
+	if (status != DISCONNECTED) socket.close();
+	this->interface = interface;
+	destination = address;
+	status = DISCONNECTED;
+	backoff = TCP_BACKOFF_MIN_MS;
+	retryTime = halMicros();
 	}
 
-void sendTCP(string& msg) {
-	if (!tcp.open(&eth)) {
-		tcp.open(&eth);
-		};
-	if (!tcp.connect(GMA3_TCP)) {
-		tcp.connect(GMA3_TCP);
-		tcp.send(msg.data(), msg.length());
-		tcp.close();
+void TcpConnection::end() {
+	ScopedLock<Mutex> lock(mutex);
+	if (status != DISCONNECTED) socket.close();
+	interface = nullptr;
+	status = DISCONNECTED;
+	queued = 0;
+	sent = 0;
+	}
+
+bool TcpConnection::send(const char* msg, uint16_t length) {
+	if (length == 0) return false;
+	ScopedLock<Mutex> lock(mutex);
+	// frames are queued with a 2 byte length header
+	if ((uint32_t)queued + 2 + length > TCP_QUEUE_SIZE) {
+		drops++;
+		update();
+		return false;
+		}
+	queue[queued++] = length >> 8;
+	queue[queued++] = length;
+	memcpy(queue + queued, msg, length);
+	queued += length;
+	update();
+	return true;
+	}
+
+void TcpConnection::update() {
+	if (interface == nullptr) return;
+	ScopedLock<Mutex> lock(mutex);
+	uint32_t now = halMicros();
+	nsapi_error_t result;
+	switch (status) {
+		case DISCONNECTED:
+			if ((int32_t)(now - retryTime) < 0) return;
+			socket.open(interface);
+			socket.set_blocking(false);
+			status = CONNECTING;
+			connectTime = now;
+			// fall through
+		case CONNECTING:
+			result = socket.connect(destination);
+			if ((result == NSAPI_ERROR_OK) || (result == NSAPI_ERROR_IS_CONNECTED)) {
+				status = CONNECTED;
+				backoff = TCP_BACKOFF_MIN_MS;
+				}
+			else if ((result == NSAPI_ERROR_IN_PROGRESS) || (result == NSAPI_ERROR_ALREADY) || (result == NSAPI_ERROR_WOULD_BLOCK)) {
+				if (now - connectTime > TCP_CONNECT_TIMEOUT_MS * 1000) fail();
+				return;
+				}
+			else {
+				fail();
+				return;
+				}
+			// fall through
+		case CONNECTED:
+			flush();
+			break;
+		}
+	}
+
+uint16_t TcpConnection::receive(char* data, uint16_t size) {
+	ScopedLock<Mutex> lock(mutex);
+	if (status != CONNECTED) return 0;
+	nsapi_size_or_error_t result = socket.recv(data, size);
+	if (result == NSAPI_ERROR_WOULD_BLOCK) return 0;
+	if (result <= 0) {
+		// 0 is a closed connection
+		fail();
+		return 0;
+		}
+	return result;
+	}
+
+connection_t TcpConnection::state() {
+	return status;
+	}
+
+uint32_t TcpConnection::dropped() {
+	return drops;
+	}
+
+bool TcpConnection::assigned(const SocketAddress& address) {
+	return (interface != nullptr) && (destination == address);
+	}
+
+bool TcpConnection::assigned() {
+	return interface != nullptr;
+	}
+
+void TcpConnection::flush() {
+	while (queued > 0) {
+		uint16_t length = ((uint8_t)queue[0] << 8) | (uint8_t)queue[1];
+		nsapi_size_or_error_t result = socket.send(queue + 2 + sent, length - sent);
+		if (result == NSAPI_ERROR_WOULD_BLOCK) return;
+		if (result < 0) {
+			fail();
+			return;
+			}
+		sent += result;
+		if (sent < length) return;
+		// remove the frame from the queue
+		queued -= 2 + length;
+		memmove(queue, queue + 2 + length, queued);
+		sent = 0;
 		}
 	}
 
-void sendTCP(string& msg, SocketAddress address) {
-	tcpExtern.set_blocking(false);
-	tcpExtern.set_timeout(50);
-	if (!tcpExtern.open(&eth)) {
-		tcpExtern.open(&eth);
-		};
-	if (!tcpExtern.connect(address)) {
-		tcpExtern.connect(address);
-		tcpExtern.send(msg.data(), msg.length());
-		tcpExtern.close();
+void TcpConnection::fail() {
+	socket.close();
+	status = DISCONNECTED;
+	retryTime = halMicros() + backoff * 1000;
+	backoff = (backoff * 2 > TCP_BACKOFF_MAX_MS) ? TCP_BACKOFF_MAX_MS : backoff * 2;
+	// a partly sent frame can't continue on a new connection
+	if (sent > 0) {
+		uint16_t length = ((uint8_t)queue[0] << 8) | (uint8_t)queue[1];
+		queued -= 2 + length;
+		memmove(queue, queue + 2 + length, queued);
+		sent = 0;
+		drops++;
 		}
 	}
 
 void setPrefix(string prefix) {
 	prefixName = prefix;
+	nameGeneration++;
+	renderPageBanks();
 	}
 
 void prefix(string prefix) {
 	prefixName = prefix;
+	nameGeneration++;
+	renderPageBanks();
 	}
 
 void page(string page) {
 	pageName = page;
+	nameGeneration++;
+	renderPageBanks();
 	}
 
 void fader(string fader) {
 	faderName = fader;
+	nameGeneration++;
+	renderPageBanks();
 	}
 
 void executorKnob(string executorKnob) {
 	executorKnobName = executorKnob;
+	nameGeneration++;
+	renderPageBanks();
 	}
 
 void key(string key) {
 	keyName = key;
+	nameGeneration++;
+	renderPageBanks();
+	}
+
+/**
+ * @brief build the address pattern of an executor element, e.g. /gma3/Page1/Fader201
+ * 
+ * @param pattern destination buffer
+ * @param size size of the buffer
+ * @param name name of the element
+ * @param page number of the page
+ * @param number number of the element
+ * @return true if the address fits into the buffer, false if it was truncated
+ */
+static bool executorPattern(char* pattern, uint16_t size, const string& name, uint16_t page, uint16_t number) {
+	int length;
+	if (prefixName.empty()) {
+		length = snprintf(pattern, size, "/%s%u/%s%u", pageName.c_str(), (unsigned)page, name.c_str(), (unsigned)number);
+		}
+	else {
+		length = snprintf(pattern, size, "/%s/%s%u/%s%u", prefixName.c_str(), pageName.c_str(), (unsigned)page, name.c_str(), (unsigned)number);
+		}
+	return (length >= 0) && (length < size);
+	}
+
+/**
+ * @brief the packet of an executor element, the cached packet is rebuild when a name has changed
+ * 
+ * @param active packet of the selected page of a PageBank, used if set
+ * @param packet cached packet
+ * @param generation name generation of the packet
+ * @param name name of the element
+ * @param page number of the page
+ * @param number number of the element
+ * @param tag type tag of the argument
+ * @return OscPacket& packet to send
+ */
+static OscPacket& executorPacket(OscPacket* active, OscPacket& packet, uint32_t& generation, const string& name, uint16_t page, uint16_t number, char tag = 'i') {
+	if (active) return *active;
+	if (generation == nameGeneration) return packet;
+	char pattern[OSC_PATTERN_SIZE];
+	// a truncated address would reach another executor, the cleared packet isn't sent
+	if (executorPattern(pattern, sizeof(pattern), name, page, number)) packet.build(pattern, tag);
+	else packet.clear();
+	generation = nameGeneration;
+	return packet;
+	}
+
+/**
+ * @brief send an unframed message with the framing of the given protocol,
+ * runs in the network thread while it's started, otherwise in the main thread
+ * 
+ * @return true if the message was sent
+ */
+static bool transmit(const char* osc, uint16_t length, protocol_t protocol, const SocketAddress* address = nullptr) {
+	PROFILE_SCOPE((protocol == UDP) ? profileUdp : profileTcp);
+	switch (protocol) {
+		case UDP:
+			return address ? sendUDP(osc, length, *address) : sendUDP(osc, length);
+		case TCP:
+			return address ? sendTCP(osc, length, *address) : sendTCP(osc, length);
+		case TCP10:
+			memcpy(frameBuffer, osc, length);
+			length = tcpEncode(frameBuffer, length, sizeof(frameBuffer));
+			if (length == 0) return false;
+			return address ? sendTCP(frameBuffer, length, *address) : sendTCP(frameBuffer, length);
+		case TCP11:
+			length = slipEncode(osc, length, frameBuffer, sizeof(frameBuffer));
+			if (length == 0) return false;
+			return address ? sendTCP(frameBuffer, length, *address) : sendTCP(frameBuffer, length);
+		}
+	return false;
+	}
+
+/**
+ * @brief send a message to the destinations of the targets, within their rate limits
+ * 
+ * @return true if a destination got the message
+ */
+static bool fanOut(const char* osc, uint16_t length, uint8_t targets) {
+	bool result = false;
+	ScopedLock<Mutex> lock(destinationMutex);
+	uint32_t now = halMicros();
+	for (uint8_t i = 0; i < DESTINATIONS; i++) {
+		Destination& entry = destinations[i];
+		if (!entry.used || !(targets & (TARGET_CONSOLE << (i + 1)))) continue;
+		if (entry.rate) {
+			// refill the token bucket, a token is 1000000 for an exact refill in us
+			entry.tokens += (uint64_t)(now - entry.refillTime) * entry.rate;
+			entry.refillTime = now;
+			if (entry.tokens > entry.capacity) entry.tokens = entry.capacity;
+			if (entry.tokens < 1000000) {
+				entry.limited++;
+				continue;
+				}
+			entry.tokens -= 1000000;
+			}
+		if (transmit(osc, length, entry.protocol, &entry.address)) result = true;
+		}
+	return result;
+	}
+
+static void flushBundle(OscBundle& bundle, protocol_t protocol) {
+	if (bundle.count() == 0) return;
+	transmit(bundle.data(), bundle.length(), protocol);
+	bundle.clear();
+	}
+
+/**
+ * @brief deliver an unframed message to the console, batched into a bundle when enabled,
+ * and to the destinations of the targets
+ * 
+ * @return true if the message was sent or added to a bundle, for the console if it's a target
+ */
+static bool deliver(const char* osc, uint16_t length, protocol_t protocol, uint8_t targets = TARGET_CONSOLE) {
+	bool result = true;
+	if (targets & destinationTargets) result = fanOut(osc, length, targets);
+	if (!(targets & TARGET_CONSOLE)) return result;
+	if (!bundling) return transmit(osc, length, protocol);
+	result = true;
+	if (protocol == UDP) {
+		if (!udpBundle.add(osc, length)) {
+			flushBundle(udpBundle, UDP);
+			if (!udpBundle.add(osc, length)) result = transmit(osc, length, UDP);
+			}
+		if (udpBundle.age() >= bundleDeadline) flushBundle(udpBundle, UDP);
+		return result;
+		}
+	// the TCP bundle has a single framing
+	if (protocol != tcpBundleProtocol) {
+		flushBundle(tcpBundle, tcpBundleProtocol);
+		tcpBundleProtocol = protocol;
+		}
+	if (!tcpBundle.add(osc, length)) {
+		flushBundle(tcpBundle, protocol);
+		if (!tcpBundle.add(osc, length)) result = transmit(osc, length, protocol);
+		}
+	if (tcpBundle.age() >= bundleDeadline) flushBundle(tcpBundle, protocol);
+	return result;
+	}
+
+/**
+ * @brief deliver all queued messages
+ * 
+ */
+static void drainQueue() {
+	uint16_t length;
+	protocol_t protocol;
+	uint8_t targets;
+	const char* osc;
+	while ((osc = outQueue.front(length, protocol, targets)) != nullptr) {
+		deliver(osc, length, protocol, targets);
+		outQueue.pop();
+		}
+	coalesceTime = halMicros();
+	}
+
+/**
+ * @brief send an unframed message to the console and the destinations, queued for the network thread when it runs
+ * 
+ * @param mode coalescing with a pending message with the same address, KEEP, LATEST or SUM
+ * @param targets TARGET_CONSOLE and the bits of the destinations
+ * @return true if the message was sent or queued
+ */
+static bool post(const char* osc, uint16_t length, protocol_t protocol, coalesce_t mode, uint8_t targets) {
+	if (length == 0) return false;
+	if (networkTask) {
+		if (!outQueue.push(osc, length, protocol, mode, targets)) return false;
+		if (!coalescing) networkSignal.release();
+		return true;
+		}
+	if (coalescing) {
+		if (outQueue.push(osc, length, protocol, mode, targets)) return true;
+		// the queue is full, make room
+		drainQueue();
+		if (outQueue.push(osc, length, protocol, mode, targets)) return true;
+		}
+	return deliver(osc, length, protocol, targets);
+	}
+
+/**
+ * @brief network thread, sends the queued messages and keeps the TCP connections alive
+ * 
+ */
+static void networkLoop() {
+	while (core_util_atomic_load_bool(&networkRunning)) {
+		drainQueue();
+		// the queue is empty, nothing more to batch
+		flushBundle(udpBundle, UDP);
+		flushBundle(tcpBundle, tcpBundleProtocol);
+		tcp.update();
+		for (uint8_t i = 0; i < TCP_CONNECTIONS; i++) {
+			tcpExtern[i].update();
+			}
+#if GMA3_PROFILE
+		// the delivery probes belong to this thread
+		if (core_util_atomic_exchange_bool(&profileRequest, false)) profileDeliveries();
+#endif
+		if (core_util_atomic_load_bool(&coalescing)) {
+			// collect the messages for one interval
+			ThisThread::sleep_for(std::chrono::milliseconds(coalesceInterval));
+			while (networkSignal.try_acquire());
+			}
+		else {
+			networkSignal.try_acquire_for(std::chrono::milliseconds(NETWORK_IDLE_MS));
+			}
+		}
+	}
+
+void bundle(bool enable, uint16_t deadline) {
+	if (!enable) flushBundle();
+	bundling = enable;
+	bundleDeadline = deadline * 1000;
+	}
+
+void flushBundle() {
+	if (networkTask) return; // the network thread sends the bundles when the queue is empty
+	flushBundle(udpBundle, UDP);
+	flushBundle(tcpBundle, tcpBundleProtocol);
+	}
+
+void networkThread(bool enable) {
+	if (enable == (networkTask != nullptr)) return;
+	if (enable) {
+		core_util_atomic_store_bool(&networkRunning, true);
+		networkTask = new Thread(osPriorityNormal, NETWORK_STACK_SIZE);
+		networkTask->start(callback(networkLoop));
+		return;
+		}
+	core_util_atomic_store_bool(&networkRunning, false);
+	networkSignal.release();
+	networkTask->join();
+	delete networkTask;
+	networkTask = nullptr;
+	// messages queued meanwhile are sent directly
+	drainQueue();
+	flushBundle();
+	}
+
+void coalesce(bool enable, uint16_t interval) {
+	coalesceInterval = interval ? interval : 1;
+	core_util_atomic_store_bool(&coalescing, enable);
+	if (!enable && !networkTask) drainQueue();
+	}
+
+uint32_t droppedQueue() {
+	return outQueue.dropped();
+	}
+
+int8_t destination(uint8_t ip[], uint16_t port, protocol_t protocol, uint16_t rate, uint16_t burst) {
+	ScopedLock<Mutex> lock(destinationMutex);
+	for (uint8_t i = 0; i < DESTINATIONS; i++) {
+		Destination& entry = destinations[i];
+		if (entry.used) continue;
+		entry.address = SocketAddress(ip, NSAPI_IPv4, port);
+		entry.protocol = protocol;
+		entry.rate = rate;
+		entry.capacity = (uint64_t)(burst ? burst : 1) * 1000000;
+		entry.tokens = entry.capacity;
+		entry.refillTime = halMicros();
+		entry.limited = 0;
+		entry.shares = 0;
+		entry.used = true;
+		destinationTargets |= TARGET_CONSOLE << (i + 1);
+		return i;
+		}
+	return -1;
+	}
+
+/**
+ * @brief the destination entry of an OscButton, shared by all buttons with the same address and protocol
+ * 
+ * @return int8_t index of the destination, -1 if the table is full
+ */
+static int8_t shareDestination(const SocketAddress& address, protocol_t protocol) {
+	ScopedLock<Mutex> lock(destinationMutex);
+	int8_t free = -1;
+	for (uint8_t i = 0; i < DESTINATIONS; i++) {
+		Destination& entry = destinations[i];
+		if (!entry.used) {
+			if (free < 0) free = i;
+			continue;
+			}
+		if (entry.shares && (entry.protocol == protocol) && (entry.address == address)) {
+			entry.shares++;
+			return i;
+			}
+		}
+	if (free < 0) return -1;
+	Destination& entry = destinations[free];
+	entry.address = address;
+	entry.protocol = protocol;
+	entry.rate = 0;
+	entry.capacity = 1000000;
+	entry.tokens = entry.capacity;
+	entry.refillTime = halMicros();
+	entry.limited = 0;
+	entry.shares = 1;
+	entry.used = true;
+	destinationTargets |= TARGET_CONSOLE << (free + 1);
+	return free;
+	}
+
+/**
+ * @brief release the destination entry of an OscButton, the last button removes it
+ * 
+ */
+static void releaseDestination(int8_t index) {
+	ScopedLock<Mutex> lock(destinationMutex); // recursive, removeDestination() locks again
+	if (--destinations[index].shares == 0) removeDestination(index);
+	}
+
+void removeDestination(int8_t index) {
+	if ((index < 0) || (index >= DESTINATIONS)) return;
+	ScopedLock<Mutex> lock(destinationMutex);
+	Destination& entry = destinations[index];
+	if (!entry.used) return;
+	entry.used = false;
+	destinationTargets &= ~(TARGET_CONSOLE << (index + 1));
+	if (entry.protocol == UDP) return;
+	// the connection is released with the last TCP destination to its address
+	for (uint8_t i = 0; i < DESTINATIONS; i++) {
+		if (destinations[i].used && (destinations[i].protocol != UDP) && (destinations[i].address == entry.address)) return;
+		}
+	releaseTCP(entry.address);
+	}
+
+uint32_t destinationDropped(int8_t index) {
+	if ((index < 0) || (index >= DESTINATIONS)) return 0;
+	return destinations[index].limited;
+	}
+
+OscQueue::OscQueue() {
+	for (uint8_t i = 0; i < QUEUE_SLOTS; i++) {
+		slots[i].state = SLOT_EMPTY;
+		}
+	head = 0;
+	tail = 0;
+	drops = 0;
+	replaces = 0;
+	}
+
+bool OscQueue::push(const char* msg, uint16_t length, protocol_t protocol, coalesce_t mode, uint8_t targets) {
+	if (length > OSC_MESSAGE_SIZE) {
+		drops++;
+		return false;
+		}
+	uint32_t first = core_util_atomic_load_u32(&tail);
+	uint16_t address = 0;
+	uint32_t hash = 2166136261u; // FNV-1a
+	int32_t pending = 0;
+	if (mode != KEEP) {
+		while ((address < length) && (msg[address] != '\0')) {
+			hash = (hash ^ (uint8_t)msg[address]) * 16777619u;
+			address++;
+			}
+		// only a single int32 argument can be summed
+		uint16_t tags = (address / 4 + 1) * 4;
+		if ((mode == SUM) && ((length != tags + 8) || (memcmp(msg + tags, ",i\0\0", 4) != 0))) mode = KEEP;
+		}
+	bool full = (head - first >= QUEUE_SLOTS);
+	if (mode != KEEP) {
+		// take over the newest queued message with the same address, unless the consumer has it already
+		for (uint32_t i = head; i != first; i--) {
+			Slot& slot = slots[(i - 1) % QUEUE_SLOTS];
+			if ((slot.hash != hash) || (slot.mode != mode) || (slot.address != address) || (slot.protocol != protocol) || (slot.targets != targets)) continue;
+			if (memcmp(slot.data, msg, address) != 0) continue;
+			uint8_t state = SLOT_READY;
+			if (full) {
+				// no free slot, the queued message gets the new value in place
+				if (core_util_atomic_cas_u8(&slot.state, &state, SLOT_WRITING)) {
+					if (mode == SUM) {
+						oscStore32(slot.data + slot.length - 4, oscLoad32(slot.data + slot.length - 4) + oscLoad32(msg + length - 4));
+						}
+					else {
+						memcpy(slot.data, msg, length);
+						slot.length = length;
+						}
+					core_util_atomic_store_u8(&slot.state, SLOT_READY);
+					replaces++;
+					return true;
+					}
+				}
+			else if (!full && core_util_atomic_cas_u8(&slot.state, &state, SLOT_DROPPED)) {
+				// the new slot is free, so the old one can be dropped
+				replaces++;
+				if (mode == SUM) pending = oscLoad32(slot.data + slot.length - 4);
+				}
+			break;
+			}
+		}
+	if (full) {
+		drops++;
+		return false;
+		}
+	Slot& slot = slots[head % QUEUE_SLOTS];
+	memcpy(slot.data, msg, length);
+	if (pending) {
+		oscStore32(slot.data + length - 4, oscLoad32(msg + length - 4) + pending);
+		}
+	slot.length = length;
+	slot.protocol = protocol;
+	slot.targets = targets;
+	slot.mode = mode;
+	slot.address = address;
+	slot.hash = (mode != KEEP) ? hash : 0;
+	core_util_atomic_store_u8(&slot.state, SLOT_READY);
+	core_util_atomic_store_u32(&head, head + 1);
+	return true;
+	}
+
+const char* OscQueue::front(uint16_t& length, protocol_t& protocol, uint8_t& targets) {
+	uint32_t last = core_util_atomic_load_u32(&head);
+	while (tail != last) {
+		Slot& slot = slots[tail % QUEUE_SLOTS];
+		uint8_t state = SLOT_READY;
+		if (core_util_atomic_cas_u8(&slot.state, &state, SLOT_BUSY) || (state == SLOT_BUSY)) {
+			length = slot.length;
+			protocol = (protocol_t)slot.protocol;
+			targets = slot.targets;
+			return slot.data;
+			}
+		if (state == SLOT_WRITING) return nullptr; // try again after the producer
+		// replaced by a newer message
+		core_util_atomic_store_u8(&slot.state, SLOT_EMPTY);
+		core_util_atomic_store_u32(&tail, tail + 1);
+		}
+	return nullptr;
+	}
+
+void OscQueue::pop() {
+	if (tail == core_util_atomic_load_u32(&head)) return;
+	core_util_atomic_store_u8(&slots[tail % QUEUE_SLOTS].state, SLOT_EMPTY);
+	core_util_atomic_store_u32(&tail, tail + 1);
+	}
+
+uint16_t OscQueue::count() {
+	return core_util_atomic_load_u32(&head) - core_util_atomic_load_u32(&tail);
+	}
+
+uint32_t OscQueue::dropped() {
+	return drops;
 	}
 
-Key::Key(PinName pin, uint16_t page, uint16_t key, protocol_t protocol) : mypin(pin, PullUp) {
-	last = mypin;
+uint32_t OscQueue::replaced() {
+	return replaces;
+	}
+
+void scheduleControl(Control* control, uint32_t due) {
+	Control*& slot = controlsWheel[due % SCHEDULER_SLOTS];
+	control->due = due;
+	control->next = slot;
+	control->scheduled = true;
+	slot = control;
+	}
+
+void unscheduleControl(Control* control) {
+	Control** list = control->scheduled ? &controlsWheel[control->due % SCHEDULER_SLOTS] : &controlsPending;
+	for (; *list; list = &(*list)->next) {
+		if (*list == control) {
+			*list = control->next;
+			break;
+			}
+		}
+	control->next = nullptr;
+	control->scheduled = false;
+	}
+
+void updateControls() {
+#if GMA3_PROFILE
+	uint32_t cycles = halCycles();
+	if (profileLast) profilePeriod.add(cycles - profileLast);
+	profileLast = cycles;
+	if (profiling && (halMicros() - profileTime >= profileInterval * 1000u)) {
+		profileTime = halMicros();
+		profileSend(); // before the probe, the report isn't part of the pass
+		}
+	PROFILE_SCOPE(profileLoop);
+#endif
+	uint32_t now = halMicros();
+	if (!wheelStarted) {
+		wheelTime = now;
+		wheelStarted = true;
+		}
+	// new controls are due now
+	while (controlsPending) {
+		Control* control = controlsPending;
+		controlsPending = control->next;
+		scheduleControl(control, wheelTick);
+		}
+	// advance the wheel, the remainder is kept for the next call
+	uint32_t ticks = (now - wheelTime) / SCHEDULER_TICK_US;
+	wheelTime += ticks * SCHEDULER_TICK_US;
+	uint32_t slots = (ticks < SCHEDULER_SLOTS) ? ticks + 1 : SCHEDULER_SLOTS;
+	uint32_t first = wheelTick;
+	wheelTick += ticks;
+	bool updated = false;
+	for (uint32_t i = 0; i < slots; i++) {
+		// detach the slot, so rescheduled controls are not visited twice
+		Control* list = controlsWheel[(first + i) % SCHEDULER_SLOTS];
+		controlsWheel[(first + i) % SCHEDULER_SLOTS] = nullptr;
+		while (list) {
+			Control* control = list;
+			list = control->next;
+			if ((int32_t)(control->due - wheelTick) <= 0) {
+				scheduleControl(control, wheelTick + control->period);
+#if GMA3_PROFILE
+				uint32_t start = halCycles();
+				control->tick();
+				control->profile.add(halCycles() - start);
+#else
+				control->tick();
+#endif
+				updated = true;
+				}
+			else {
+				scheduleControl(control, control->due);
+				}
+			}
+		}
+	if (coalescing && !networkTask && (now - coalesceTime >= coalesceInterval * 1000u)) drainQueue();
+	if (updated && bundling) flushBundle();
+	}
+
+#if GMA3_PROFILE
+Profile::Profile() {
+	reset();
+	}
+
+void Profile::add(uint32_t cycles) {
+	samples++;
+	total += cycles;
+	if (cycles < minimum) minimum = cycles;
+	if (cycles > maximum) maximum = cycles;
+	// 4 buckets per octave, the 2 bits below the highest set bit select the bucket
+	uint32_t bucket = cycles;
+	if (cycles >= 4) {
+		uint8_t msb = 31 - __builtin_clz(cycles);
+		bucket = (msb - 1) * 4 + ((cycles >> (msb - 2)) & 3);
+		}
+	if (bucket >= PROFILE_BUCKETS) bucket = PROFILE_BUCKETS - 1;
+	if (histogram[bucket] < UINT16_MAX) histogram[bucket]++;
+	}
+
+void Profile::reset() {
+	samples = 0;
+	minimum = UINT32_MAX;
+	maximum = 0;
+	total = 0;
+	memset(histogram, 0, sizeof(histogram));
+	}
+
+uint32_t Profile::count() {
+	return samples;
+	}
+
+uint32_t Profile::min() {
+	return samples ? minimum : 0;
+	}
+
+uint32_t Profile::mean() {
+	return samples ? total / samples : 0;
+	}
+
+uint32_t Profile::max() {
+	return maximum;
+	}
+
+uint32_t Profile::percentile(uint8_t percent) {
+	if (samples == 0) return 0;
+	// the histogram saturates, so the rank is taken from its own sum
+	uint32_t counted = 0;
+	for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) counted += histogram[i];
+	uint32_t rank = ((uint64_t)counted * percent + 99) / 100;
+	uint32_t sum = 0;
+	for (uint8_t i = 0; i < PROFILE_BUCKETS; i++) {
+		sum += histogram[i];
+		if (sum < rank) continue;
+		if (i < 4) return i;
+		uint8_t msb = i / 4 + 1;
+		uint32_t upper = ((uint64_t)(5 + i % 4) << (msb - 2)) - 1;
+		return upper < maximum ? upper : maximum;
+		}
+	return maximum;
+	}
+
+static int32_t profileNanos(uint32_t cycles) {
+	return (uint64_t)cycles * 1000000000 / halCycleFrequency();
+	}
+
+static void profileMessage(const char* label, Profile& profile) {
+	char osc[OSC_MESSAGE_SIZE];
+	OscWriter writer(osc, sizeof(osc));
+	writer.begin(PROFILE_ADDRESS, "siiiii");
+	writer.add(label);
+	writer.add((int32_t)profile.count());
+	writer.add(profileNanos(profile.min()));
+	writer.add(profileNanos(profile.mean()));
+	writer.add(profileNanos(profile.percentile(99)));
+	writer.add(profileNanos(profile.max()));
+	if (writer.length()) sendUDP(osc, writer.length(), profileAddress);
+	profile.reset();
+	}
+
+static void profileDeliveries() {
+	profileMessage("udp", profileUdp);
+	profileMessage("tcp", profileTcp);
+	}
+
+void profileSend() {
+	profileMessage("loop", profileLoop);
+	profileMessage("period", profilePeriod);
+	if (networkTask) core_util_atomic_store_bool(&profileRequest, true);
+	else {
+		core_util_atomic_store_bool(&profileRequest, false);
+		profileDeliveries();
+		}
+	for (Control* control = controlsAll; control; control = control->nextControl) {
+		char name[OSC_PATTERN_SIZE];
+		control->label(name, sizeof(name));
+		profileMessage(name, control->profile);
+		}
+	}
+
+void profileReport(uint8_t ip[], uint16_t port, uint16_t interval) {
+	profileAddress = SocketAddress(ip, NSAPI_IPv4, port);
+	profileInterval = interval;
+	profileTime = halMicros();
+	profiling = port != 0;
+	}
+#endif
+
+Control::Control(uint16_t period) {
+	due = 0;
+	scheduled = false;
+	rate(period);
+	next = controlsPending;
+	controlsPending = this;
+	nextControl = controlsAll;
+	controlsAll = this;
+	targets = TARGET_ALL;
+	resetStats();
+	}
+
+Control::~Control() {
+	unscheduleControl(this);
+	for (Control** list = &controlsAll; *list; list = &(*list)->nextControl) {
+		if (*list == this) {
+			*list = nextControl;
+			break;
+			}
+		}
+	}
+
+void Control::rate(uint16_t period) {
+	this->period = (uint32_t)period * 1000 / SCHEDULER_TICK_US;
+	if (this->period == 0) this->period = 1;
+	}
+
+void Control::tick() {
+	update();
+	}
+
+const ControlStats& Control::stats() {
+	return counters;
+	}
+
+void Control::resetStats() {
+	memset(&counters, 0, sizeof(counters));
+	}
+
+void Control::label(char* buffer, uint16_t size) {
+	snprintf(buffer, size, "control");
+	}
+
+void Control::route(uint8_t targets) {
+	this->targets = targets;
+	}
+
+bool Control::send(const char* osc, uint16_t length, protocol_t protocol, coalesce_t mode) {
+	return post(osc, length, protocol, mode, targets);
+	}
+
+void Control::record(bool sent, uint32_t start) {
+	if (!sent) {
+		counters.failures++;
+		return;
+		}
+	counters.sends++;
+	uint32_t latency = halMicros() - start;
+	uint8_t bucket = latency ? 32 - __builtin_clz(latency) : 0;
+	if (bucket >= STATS_BUCKETS) bucket = STATS_BUCKETS - 1;
+	counters.latency[bucket]++;
+	}
+
+void reportControls(uint8_t ip[], uint16_t port) {
+	SocketAddress address(ip, NSAPI_IPv4, port);
+	// label, 4 counters and the histogram
+	char tags[6 + STATS_BUCKETS];
+	tags[0] = 's';
+	memset(tags + 1, 'i', 4 + STATS_BUCKETS);
+	tags[5 + STATS_BUCKETS] = '\0';
+	for (Control* control = controlsAll; control; control = control->nextControl) {
+		char name[OSC_PATTERN_SIZE];
+		char osc[OSC_MESSAGE_SIZE];
+		const ControlStats& stats = control->counters;
+		control->label(name, sizeof(name));
+		OscWriter writer(osc, sizeof(osc));
+		writer.begin(STATS_ADDRESS, tags);
+		writer.add(name);
+		writer.add((int32_t)stats.samples);
+		writer.add((int32_t)stats.sends);
+		writer.add((int32_t)stats.suppressed);
+		writer.add((int32_t)stats.failures);
+		writer.add((const int32_t*)stats.latency, STATS_BUCKETS);
+		if (writer.length()) sendUDP(osc, writer.length(), address);
+		}
+	}
+
+Debouncer::Debouncer(PinName pin, uint16_t lockout) : mypin(pin, PullUp) {
+	level = mypin.read();
+	bounced = false;
+	bounceCount = 0;
+	edgeTime = halMicros();
+	bounceTime = edgeTime;
+	head = 0;
+	tail = 0;
+	this->lockout(lockout);
+	mypin.rise(callback(this, &Debouncer::edgeISR));
+	mypin.fall(callback(this, &Debouncer::edgeISR));
+	}
+
+void Debouncer::lockout(uint16_t lockout) {
+	lockoutTime = (uint32_t)lockout * 1000;
+	}
+
+void Debouncer::edgeISR() {
+	uint32_t now = halMicros();
+	if (now - edgeTime < lockoutTime) {
+		// bouncing
+		bounced = true;
+		bounceTime = now;
+		core_util_atomic_fetch_add_s32(&bounceCount, 1);
+		return;
+		}
+	bool value = mypin.read();
+	if (value == level) return;
+	level = value;
+	edgeTime = now;
+	bounced = false;
+	push(value, now);
+	}
+
+void Debouncer::push(bool level, uint32_t time) {
+	if (head - tail >= DEBOUNCE_EVENTS) return;
+	edges[head % DEBOUNCE_EVENTS].level = level;
+	edges[head % DEBOUNCE_EVENTS].time = time;
+	core_util_atomic_store_u32(&head, head + 1);
+	}
+
+bool Debouncer::event(bool& level, uint32_t& time) {
+	if (tail == core_util_atomic_load_u32(&head)) {
+		// the pin can settle at the other level while the edges are locked out
+		core_util_critical_section_enter();
+		if (bounced && (halMicros() - edgeTime >= lockoutTime)) {
+			bool value = mypin.read();
+			if (value != this->level) {
+				this->level = value;
+				edgeTime = bounceTime;
+				push(value, bounceTime);
+				}
+			bounced = false;
+			}
+		core_util_critical_section_exit();
+		if (tail == core_util_atomic_load_u32(&head)) return false;
+		}
+	level = edges[tail % DEBOUNCE_EVENTS].level;
+	time = edges[tail % DEBOUNCE_EVENTS].time;
+	core_util_atomic_store_u32(&tail, tail + 1);
+	return true;
+	}
+
+bool Debouncer::read() {
+	return level;
+	}
+
+uint32_t Debouncer::bounces() {
+	return core_util_atomic_exchange_s32(&bounceCount, 0);
+	}
+
+Key::Key(PinName pin, uint16_t page, uint16_t key, protocol_t protocol) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
+	generation = 0;
+	active = nullptr;
+	held = nullptr;
 	this->page = page;
 	this->key = key;
 	this->protocol = protocol;
 	}
 
 void Key::update() {
-	if (mypin != last) {
-		string oscPattern = "/";
-		if (!prefixName.empty()) oscPattern += prefixName + "/";
-		oscPattern += pageName + to_string(page) + "/" + keyName + to_string(key);
-		if (last == false) {
-			last = true;
-			message(oscPattern, BUTTON_RELEASE, protocol);
+	bool level;
+	counters.samples++;
+	counters.suppressed += mypin.bounces();
+	while (mypin.event(level, edgeTime)) {
+		OscPacket* out;
+		if (level && held) {
+			// release on the page of the press
+			out = held;
+			held = nullptr;
 			}
 		else {
-			last = false;
-			message(oscPattern, BUTTON_PRESS, protocol);
+			out = &executorPacket(active, packet, generation, keyName, page, key);
+			held = level ? nullptr : out;
 			}
-		if (protocol == UDP) {
-			sendUDP(oscPattern);
-			return;
+		out->set(level ? BUTTON_RELEASE : BUTTON_PRESS);
+		record(send(out->data(), out->length(), protocol), edgeTime);
+		}
+	}
+
+void Key::label(char* buffer, uint16_t size) {
+	executorPattern(buffer, size, keyName, page, key);
+	}
+
+void Key::debounce(uint16_t lockout) {
+	mypin.lockout(lockout);
+	}
+
+uint32_t Key::timestamp() {
+	return edgeTime;
+	}
+
+KeyMatrix::KeyMatrix(const PinName rows[], uint8_t rowCount, const PinName columns[], uint8_t columnCount, uint16_t page, uint16_t key, protocol_t protocol) : Control(BUTTON_UPDATE_RATE_MS) {
+	if (rowCount > KEY_MATRIX_ROWS) rowCount = KEY_MATRIX_ROWS;
+	if (columnCount > KEY_MATRIX_COLUMNS) columnCount = KEY_MATRIX_COLUMNS;
+	if ((rowCount == 0) || (columnCount == 0)) {
+		// an empty matrix has no keys and is never scanned
+		rowCount = 0;
+		columnCount = 0;
+		}
+	else if (rowCount * columnCount > KEY_MATRIX_KEYS) rowCount = KEY_MATRIX_KEYS / columnCount;
+	for (uint8_t i = 0; i < rowCount; i++) {
+		gpio_init_out_ex(&rowPins[i], rows[i], 1);
+		}
+	for (uint8_t i = 0; i < columnCount; i++) {
+		gpio_init_in_ex(&columnPins[i], columns[i], PullUp);
+		}
+	shift = false;
+	this->rowCount = rowCount;
+	this->columnCount = columnCount;
+	row = 0;
+	keys = rowCount * columnCount;
+	keyMap = nullptr;
+	memset(sample, 0, sizeof(sample));
+	memset(last, 0, sizeof(last));
+	memset((void*)state, 0, sizeof(state));
+	memset(reported, 0, sizeof(reported));
+	scanTime = 0;
+	this->page = page;
+	this->key = key;
+	this->protocol = protocol;
+	}
+
+KeyMatrix::KeyMatrix(PinName load, PinName clock, PinName data, uint16_t count, uint16_t page, uint16_t key, protocol_t protocol) : Control(BUTTON_UPDATE_RATE_MS) {
+	if (count > KEY_MATRIX_KEYS) count = KEY_MATRIX_KEYS;
+	gpio_init_out_ex(&loadPin, load, 1);
+	gpio_init_out_ex(&clockPin, clock, 0);
+	gpio_init_in_ex(&dataPin, data, PullUp);
+	shift = true;
+	rowCount = 0;
+	columnCount = 0;
+	row = 0;
+	keys = count;
+	keyMap = nullptr;
+	memset(sample, 0, sizeof(sample));
+	memset(last, 0, sizeof(last));
+	memset((void*)state, 0, sizeof(state));
+	memset(reported, 0, sizeof(reported));
+	scanTime = 0;
+	this->page = page;
+	this->key = key;
+	this->protocol = protocol;
+	}
+
+void KeyMatrix::begin(uint32_t period) {
+	if (keys == 0) return;
+	if (!shift) gpio_write(&rowPins[row], 0);
+	ticker.attach(callback(this, &KeyMatrix::scan), std::chrono::microseconds(period));
+	}
+
+void KeyMatrix::end() {
+	ticker.detach();
+	if (!shift && rowCount) gpio_write(&rowPins[row], 1);
+	}
+
+void KeyMatrix::map(const uint16_t keys[]) {
+	keyMap = keys;
+	}
+
+void KeyMatrix::scan() {
+	if (keys == 0) return;
+	if (shift) {
+		// latch the inputs, then shift them out, a pressed key is low
+		gpio_write(&loadPin, 0);
+		gpio_write(&loadPin, 1);
+		for (uint16_t i = 0; i < keys; i++) {
+			if (gpio_read(&dataPin)) sample[i / 32] &= ~(1u << (i % 32));
+			else sample[i / 32] |= 1u << (i % 32);
+			gpio_write(&clockPin, 1);
+			gpio_write(&clockPin, 0);
 			}
-		if ((protocol == TCP11) || (protocol == TCP10) || (protocol == TCP)) {
-			sendTCP(oscPattern);
+		debounce();
+		return;
+		}
+	// the row was driven one period ago, so the columns have settled
+	for (uint8_t column = 0; column < columnCount; column++) {
+		uint16_t i = row * columnCount + column;
+		if (gpio_read(&columnPins[column])) sample[i / 32] &= ~(1u << (i % 32));
+		else sample[i / 32] |= 1u << (i % 32);
+		}
+	gpio_write(&rowPins[row], 1);
+	row = (row + 1) % rowCount;
+	gpio_write(&rowPins[row], 0);
+	if (row == 0) debounce();
+	}
+
+void KeyMatrix::debounce() {
+	// a key changes when two complete scans agree
+	for (uint8_t w = 0; w < WORDS; w++) {
+		uint32_t stable = ~(sample[w] ^ last[w]);
+		state[w] = (state[w] & ~stable) | (sample[w] & stable);
+		last[w] = sample[w];
+		}
+	scanTime = halMicros();
+	}
+
+void KeyMatrix::update() {
+	counters.samples++;
+	for (uint8_t w = 0; w < WORDS; w++) {
+		uint32_t current = state[w];
+		uint32_t changed = current ^ reported[w];
+		reported[w] = current;
+		// only the changed keys are visited
+		while (changed) {
+			uint8_t bit = __builtin_ctz(changed);
+			changed &= changed - 1;
+			uint16_t index = w * 32 + bit;
+			char pattern[OSC_PATTERN_SIZE];
+			char osc[OSC_PACKET_SIZE];
+			if (!executorPattern(pattern, sizeof(pattern), keyName, page, keyMap ? keyMap[index] : key + index)) {
+				record(false, scanTime);
+				continue;
+				}
+			record(send(osc, message(osc, sizeof(osc), pattern, (current >> bit) & 1 ? BUTTON_PRESS : BUTTON_RELEASE), protocol), scanTime);
 			}
-		} 
+		}
+	}
+
+void KeyMatrix::label(char* buffer, uint16_t size) {
+	executorPattern(buffer, size, keyName, page, key);
+	}
+
+bool KeyMatrix::pressed(uint16_t index) {
+	if (index >= keys) return false;
+	return (state[index / 32] >> (index % 32)) & 1;
+	}
+
+uint16_t KeyMatrix::count() {
+	return keys;
+	}
+
+FaderBank::FaderBank(const PinName pins[], uint8_t count) {
+	if (count > FADER_BANK_CHANNELS) count = FADER_BANK_CHANNELS;
+	this->count = count;
+	sequence = 0;
+	for (uint8_t i = 0; i < count; i++) {
+		analogin_init(&adc[i], pins[i]);
+		samples[0][i] = 0;
+		samples[1][i] = 0;
+		}
+	}
+
+void FaderBank::begin(uint32_t period) {
+	scan();
+	ticker.attach(callback(this, &FaderBank::scan), std::chrono::microseconds(period));
+	}
+
+void FaderBank::end() {
+	ticker.detach();
+	}
+
+void FaderBank::scan() {
+	// fill the unpublished buffer, then publish it
+	uint32_t next = core_util_atomic_load_u32(&sequence) + 1;
+	uint16_t* buffer = samples[next & 1];
+	for (uint8_t i = 0; i < count; i++) {
+		buffer[i] = analogin_read_u16(&adc[i]);
+		}
+	core_util_atomic_store_u32(&sequence, next);
+	}
+
+uint16_t FaderBank::read(uint8_t channel) {
+	if (channel >= count) return 0;
+	return samples[core_util_atomic_load_u32(&sequence) & 1][channel];
+	}
+
+void FaderBank::snapshot(uint16_t samples[]) {
+	uint32_t published;
+	do {
+		// retry when a scan was published meanwhile
+		published = core_util_atomic_load_u32(&sequence);
+		memcpy(samples, this->samples[published & 1], count * sizeof(uint16_t));
+		} while (published != core_util_atomic_load_u32(&sequence));
+	}
+
+uint8_t FaderBank::channels() {
+	return count;
+	}
+
+uint32_t FaderBank::scans() {
+	return core_util_atomic_load_u32(&sequence);
 	}
 
-// TODO force output at the begin
-Fader::Fader(PinName pin, uint16_t page, uint16_t key, protocol_t protocol) : mypin(pin) {
+Fader::Fader(PinName pin, uint16_t page, uint16_t key, protocol_t protocol) : Control(FADER_UPDATE_RATE_MS) {
+	analogin_init(&adc, pin);
+	bank = nullptr;
+	channel = 0;
+	filters = nullptr;
+	oversampling = 1;
+	thresholdMoving = FADER_THRESHOLD << 6;
+	thresholdResting = FADER_THRESHOLD << 6;
+	moveTime = 0;
+	analogLast = 0;
+	valueLast = 0;
+	type = INT32;
 	this->page = page;
 	this->key = key;
 	this->protocol = protocol;
-	updateTime = us_ticker_read();
+	generation = 0;
+	active = nullptr;
+	forced = true; // send the position at the begin
+	updateTime = halMicros();
+	}
+
+Fader::Fader(FaderBank& bank, uint8_t channel, uint16_t page, uint16_t key, protocol_t protocol) : Control(FADER_UPDATE_RATE_MS) {
+	this->bank = &bank;
+	this->channel = channel;
+	filters = nullptr;
+	oversampling = 1;
+	thresholdMoving = FADER_THRESHOLD << 6;
+	thresholdResting = FADER_THRESHOLD << 6;
+	moveTime = 0;
+	analogLast = 0;
+	valueLast = 0;
+	type = INT32;
+	this->page = page;
+	this->key = key;
+	this->protocol = protocol;
+	generation = 0;
+	active = nullptr;
+	forced = true; // send the position at the begin
+	updateTime = halMicros();
+	}
+
+void Fader::update() {
+	if (halMicros() - updateTime > FADER_UPDATE_RATE_MS * 1000) { // wraparound safe
+		sample();
+		}
+	}
+
+void Fader::tick() {
+	// the scheduler already keeps the update rate
+	sample();
+	}
+
+void Fader::sample() {
+	uint32_t start = halMicros();
+	uint32_t sample = read();
+	counters.samples++;
+	for (FaderFilter* filter = filters; filter; filter = filter->next) {
+		sample = filter->filter(sample);
+		}
+	int32_t raw = limit((int32_t)sample, FADER_MIN, FADER_MAX); // limit to top / bottom 2*FADER_THRESHOLD
+	uint32_t now = halMicros();
+	int32_t threshold = (now - moveTime < FADER_SETTLE_MS * 1000) ? thresholdMoving : thresholdResting;
+	bool moved = raw < (analogLast - threshold) || raw > (analogLast + threshold); // ignore jitter
+	if (moved || forced) {
+		if (moved) {
+			analogLast = raw;
+			moveTime = now;
+			}
+		if (muted()) {
+			// follow the position without sending
+			valueLast = (analogLast >> 6) * 100 / 1015;
+			counters.suppressed++;
+			}
+		else if (type == FLOAT32) {
+			OscPacket& out = executorPacket(active, packet, generation, faderName, page, key, 'f');
+			out.set((analogLast - FADER_MIN) * 100.0f / (FADER_MAX - FADER_MIN)); // map to 0.0...100.0
+			bool sent = send(out.data(), out.length(), protocol, LATEST);
+			record(sent, start);
+			if (sent) forced = false;
+			if (protocol == UDP) return;
+			}
+		else {
+			int32_t value = (analogLast >> 6) * 100 / 1015; // map to 0...100
+			if (valueLast != value || forced) {
+				valueLast = value;
+				OscPacket& out = executorPacket(active, packet, generation, faderName, page, key);
+				out.set(value);
+				bool sent = send(out.data(), out.length(), protocol, LATEST);
+				record(sent, start);
+				if (sent) forced = false;
+				if (protocol == UDP) return;
+				}
+			else {
+				counters.suppressed++;
+				}
+			}
+		}
+	else {
+		counters.suppressed++;
+		}
+	updateTime = halMicros();
+	}
+
+uint16_t Fader::read() {
+	if (bank) return bank->read(channel);
+	uint32_t sample = 0;
+	for (uint8_t i = 0; i < oversampling; i++) {
+		sample += analogin_read_u16(&adc);
+		}
+	return sample / oversampling;
+	}
+
+bool Fader::muted() {
+	return false;
+	}
+
+void Fader::label(char* buffer, uint16_t size) {
+	executorPattern(buffer, size, faderName, page, key);
+	}
+
+void Fader::oversample(uint8_t count) {
+	oversampling = count ? count : 1;
+	}
+
+void Fader::filter(FaderFilter& filter) {
+	FaderFilter** last = &filters;
+	while (*last) last = &(*last)->next;
+	filter.next = nullptr;
+	*last = &filter;
+	}
+
+void Fader::hysteresis(uint8_t moving, uint8_t resting) {
+	thresholdMoving = moving << 6;
+	thresholdResting = resting << 6;
+	}
+
+void Fader::output(osc_t type) {
+	this->type = (type == FLOAT32) ? FLOAT32 : INT32;
+	generation = 0; // rebuild the packet with the new type tag
+	if (active) renderPageBanks();
+	}
+
+void Fader::resend() {
+	forced = true;
+	}
+
+MotorFader::MotorFader(PinName pin, PinName pwm, PinName direction, PinName touch, uint16_t page, uint16_t key, protocol_t protocol) : Fader(pin, page, key, protocol) {
+	init(pwm, direction, touch);
+	}
+
+MotorFader::MotorFader(FaderBank& bank, uint8_t channel, PinName pwm, PinName direction, PinName touch, uint16_t page, uint16_t key, protocol_t protocol) : Fader(bank, channel, page, key, protocol) {
+	init(pwm, direction, touch);
+	}
+
+MotorFader::~MotorFader() {
+	end();
+	}
+
+void MotorFader::init(PinName pwm, PinName direction, PinName touch) {
+	pwmout_init(&motor, pwm);
+	pwmout_period_us(&motor, MOTOR_FADER_PWM_US);
+	pwmout_write(&motor, 0.0f);
+	gpio_init_out_ex(&directionPin, direction, 0);
+	touchSensor = (touch != NC);
+	if (touchSensor) gpio_init_in_ex(&touchPin, touch, PullDown);
+	forced = false; // the console sends the value
+	running = false;
+	target = 0;
+	position = 0;
+	driving = false;
+	stopTime = halMicros();
+	driveTicks = 0;
+	timeoutTicks = MOTOR_FADER_TIMEOUT_MS * 1000 / MOTOR_FADER_PERIOD_US;
+	kp = MOTOR_FADER_KP;
+	ki = MOTOR_FADER_KI;
+	kd = MOTOR_FADER_KD;
+	integral = 0.0f;
+	errorLast = 0.0f;
+	}
+
+void MotorFader::begin(uint32_t period) {
+	if (period == 0) period = MOTOR_FADER_PERIOD_US;
+	timeoutTicks = MOTOR_FADER_TIMEOUT_MS * 1000 / period;
+	position = Fader::read();
+	running = true;
+	ticker.attach(callback(this, &MotorFader::control), std::chrono::microseconds(period));
+	}
+
+void MotorFader::end() {
+	ticker.detach();
+	running = false;
+	driving = false;
+	drive(0.0f);
+	}
+
+void MotorFader::pid(float kp, float ki, float kd) {
+	core_util_critical_section_enter();
+	this->kp = kp;
+	this->ki = ki;
+	this->kd = kd;
+	integral = 0.0f;
+	core_util_critical_section_exit();
+	}
+
+void MotorFader::move(float value) {
+	if (touched()) return; // the user has the fader
+	int32_t goal = FADER_MIN + limit(value, 0.0f, 100.0f) * (FADER_MAX - FADER_MIN) / 100.0f;
+	core_util_critical_section_enter();
+	target = goal;
+	integral = 0.0f;
+	errorLast = (float)(goal - (int32_t)position) / 65535.0f; // no derivative kick
+	driveTicks = 0;
+	driving = true;
+	core_util_critical_section_exit();
+	}
+
+void MotorFader::feedback(OscReader& msg, void* context) {
+	MotorFader* fader = (MotorFader*)context;
+	if ((fader == nullptr) || (msg.count() == 0)) return;
+	// with a PageBank only the value of the selected page moves the fader
+	OscPacket& out = executorPacket(fader->active, fader->packet, fader->generation, faderName, fader->page, fader->key, (fader->type == FLOAT32) ? 'f' : 'i');
+	if (strcmp(msg.address(), out.data()) != 0) return;
+	fader->move((msg.type(0) == 'f') ? msg.getFloat(0) : (float)msg.getInt(0));
+	}
+
+bool MotorFader::moving() {
+	return driving;
+	}
+
+bool MotorFader::touched() {
+	return touchSensor && gpio_read(&touchPin);
+	}
+
+void MotorFader::resend() {
+	}
+
+void MotorFader::control() {
+	// runs from the ticker, the fader is only sampled here
+	uint16_t sample = Fader::read();
+	position = sample;
+	if (!driving) return;
+	int32_t distance = target - (int32_t)sample;
+	if (touched() || (abs(distance) <= MOTOR_FADER_DEADBAND) || (++driveTicks >= timeoutTicks)) {
+		// arrived, taken by the user or blocked
+		drive(0.0f);
+		stopTime = halMicros();
+		driving = false;
+		return;
+		}
+	float error = (float)distance / 65535.0f;
+	if (ki > 0.0f) integral = limit(integral + error, -1.0f / ki, 1.0f / ki); // anti windup
+	float output = kp * error + ki * integral + kd * (error - errorLast);
+	errorLast = error;
+	drive(output);
+	}
+
+void MotorFader::drive(float output) {
+	gpio_write(&directionPin, output > 0.0f);
+	float duty = (output < 0.0f) ? -output : output;
+	if (duty > 0.0f) duty = MOTOR_FADER_MIN_DUTY + duty * (1.0f - MOTOR_FADER_MIN_DUTY);
+	pwmout_write(&motor, (duty > 1.0f) ? 1.0f : duty);
+	}
+
+uint16_t MotorFader::read() {
+	// the ticker owns the ADC while the loop runs
+	return running ? position : Fader::read();
+	}
+
+bool MotorFader::muted() {
+	if (touched()) return false; // moved by the user
+	return driving || (halMicros() - stopTime < FADER_SETTLE_MS * 1000);
+	}
+
+EmaFilter::EmaFilter(uint8_t shift) {
+	this->shift = (shift > 15) ? 15 : shift;
+	average = 0;
+	started = false;
+	}
+
+uint16_t EmaFilter::filter(uint16_t sample) {
+	if (!started) {
+		average = (uint32_t)sample << shift;
+		started = true;
+		}
+	// average += sample - average / 2^shift
+	average = average - (average >> shift) + sample;
+	return average >> shift;
+	}
+
+AverageFilter::AverageFilter(uint8_t length) {
+	if (length == 0) length = 1;
+	if (length > FADER_AVERAGE_SIZE) length = FADER_AVERAGE_SIZE;
+	this->length = length;
+	sum = 0;
+	index = 0;
+	filled = 0;
 	}
 
-void Fader::update() {
-	if (updateTime + (FADER_UPDATE_RATE_MS * 1000) < us_ticker_read()) {
-		int16_t raw = mypin.read_u16() >> 6; // reduce to 10bit
-		raw = limit(raw, 8, 1015); // limit to top / bottom 2*FADER_THRESHOLD
-		if (raw < (analogLast - FADER_THRESHOLD) || raw > (analogLast + FADER_THRESHOLD)) { // ignore jitter
-			analogLast = raw;
-			int32_t value = analogLast * 100 / 1015; // map to 0...100
-			if (valueLast != value) {
-				valueLast = value;
-				string oscPattern = "/";
-				if (!prefixName.empty()) oscPattern += prefixName + "/";
-				oscPattern += pageName + to_string(page) + "/" + faderName + to_string(key);
-				message(oscPattern, value, protocol);
-				if (protocol == UDP) {
-					sendUDP(oscPattern);
-					return;
-					}
-				if ((protocol == TCP11) || (protocol == TCP10) || (protocol == TCP)) {
-					sendTCP(oscPattern);
-					}
-				}
-			}
-		updateTime = us_ticker_read();
-		}
+uint16_t AverageFilter::filter(uint16_t sample) {
+	if (filled == length) sum -= samples[index];
+	else filled++;
+	samples[index] = sample;
+	sum += sample;
+	index = (index + 1) % length;
+	return sum / filled;
 	}
 
 
-ExecutorKnob::ExecutorKnob(PinName pinA, PinName pinB, uint16_t page, uint16_t executorKnob, uint8_t direction, protocol_t protocol) : mypinA(pinA, PullUp), mypinB(pinB, PullUp) {
-	pinALast = mypinA;
+ExecutorKnob::ExecutorKnob(PinName pinA, PinName pinB, uint16_t page, uint16_t executorKnob, uint8_t direction, protocol_t protocol) : Control(ENCODER_UPDATE_RATE_MS), mypinA(pinA, PullUp), mypinB(pinB, PullUp) {
 	this->page = page;
 	this->executorKnob = executorKnob;
 	this->direction = direction;
 	this->protocol = protocol;
+	generation = 0;
+	active = nullptr;
+	encoderCount = 0;
+	window = 0;
+	accelerationFactor = 0;
+	sendTime = halMicros();
+	encoderState = (mypinA << 1) | mypinB;
+	mypinA.rise(callback(this, &ExecutorKnob::encoderISR));
+	mypinA.fall(callback(this, &ExecutorKnob::encoderISR));
+	mypinB.rise(callback(this, &ExecutorKnob::encoderISR));
+	mypinB.fall(callback(this, &ExecutorKnob::encoderISR));
+	}
+
+void ExecutorKnob::encoderISR() {
+	// full quadrature state machine, index is last state AB and new state AB
+	static const int8_t transitions[16] = {0, 1, -1, 0, -1, 0, 0, 1, 1, 0, 0, -1, 0, -1, 1, 0};
+	uint8_t state = (mypinA << 1) | mypinB;
+	int8_t step = transitions[(encoderState << 2) | state];
+	encoderState = state;
+	if (step != 0) core_util_atomic_fetch_add_s32(&encoderCount, step);
 	}
 
 void ExecutorKnob::update() {
-	encoderMotion = 0;
-	pinACurrent = mypinA;	
-	if ((pinALast) && (!pinACurrent)) {
-		if (mypinB) {
-			encoderMotion = - 1;
-			}
-		else {
-			encoderMotion = 1;
-			}
-		if (direction == REVERSE) encoderMotion = -encoderMotion;
-		}
-	pinALast = pinACurrent;
+	int32_t encoderMotion = core_util_atomic_load_s32(&encoderCount) / ENCODER_STEPS;
+	counters.samples++;
 	if (encoderMotion != 0) {
-		string oscPattern = "/";
-		if (!prefixName.empty()) oscPattern += prefixName + "/";
-			oscPattern += pageName + to_string(page) + "/" + executorKnobName + to_string(executorKnob);
-			message(oscPattern, encoderMotion, protocol);
-		if (protocol == UDP) {
-			sendUDP(oscPattern);
+		uint32_t now = halMicros();
+		uint32_t elapsed = now - sendTime;
+		if (elapsed < window * 1000u) {
+			// keep collecting
+			counters.suppressed++;
 			return;
 			}
-		if ((protocol == TCP11) || (protocol == TCP10) || (protocol == TCP)) {
-			sendTCP(oscPattern);
+		sendTime = now;
+		// keep the steps of an incomplete detent
+		core_util_atomic_fetch_sub_s32(&encoderCount, encoderMotion * ENCODER_STEPS);
+		if (accelerationFactor) {
+			uint32_t speed = (uint64_t)abs(encoderMotion) * 1000000 / (elapsed ? elapsed : 1); // detents/s
+			if (speed > 10000) speed = 10000;
+			encoderMotion += (int64_t)encoderMotion * speed * accelerationFactor / ENCODER_ACCELERATION;
 			}
+		if (direction == REVERSE) encoderMotion = -encoderMotion;
+		OscPacket& out = executorPacket(active, packet, generation, executorKnobName, page, executorKnob);
+		out.set(encoderMotion);
+		record(send(out.data(), out.length(), protocol, SUM), now);
 		}
 	}
 
+void ExecutorKnob::label(char* buffer, uint16_t size) {
+	executorPattern(buffer, size, executorKnobName, page, executorKnob);
+	}
+
+
+void ExecutorKnob::coalesce(uint16_t window) {
+	this->window = window;
+	}
 
-CmdButton::CmdButton(PinName pin, string command, protocol_t protocol) : mypin(pin, PullUp) {
-	last = mypin;
+void ExecutorKnob::acceleration(uint8_t factor) {
+	accelerationFactor = factor;
+	}
+
+
+CmdButton::CmdButton(PinName pin, string command, protocol_t protocol) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
 	this->command = command;
 	this->protocol = protocol;
 	}
 
 void CmdButton::update() {
-	if (mypin != last) {
-		string oscPattern = "/";
-		if (!prefixName.empty()) oscPattern += prefixName + "/";
-		oscPattern += "cmd";
-		if (last == false) {
-			last = true;
-			}
-		else {
-			last = false;
-			message(oscPattern, command, protocol);
-			if (protocol == UDP) {
-				sendUDP(oscPattern);
-				return;
-				}
-			if ((protocol == TCP11) || (protocol == TCP10) || (protocol == TCP)) {
-				sendTCP(oscPattern);
-				}
-			}	
-		} 
+	bool level;
+	counters.samples++;
+	counters.suppressed += mypin.bounces();
+	while (mypin.event(level, edgeTime)) {
+		if (level) continue; // released
+		char pattern[OSC_PATTERN_SIZE];
+		char osc[OSC_MESSAGE_SIZE];
+		if (prefixName.empty()) snprintf(pattern, sizeof(pattern), "/cmd");
+		else snprintf(pattern, sizeof(pattern), "/%s/cmd", prefixName.c_str());
+		record(send(osc, message(osc, sizeof(osc), pattern, command.c_str()), protocol), edgeTime);
+		}
+	}
+
+void CmdButton::label(char* buffer, uint16_t size) {
+	snprintf(buffer, size, "%s", command.c_str());
+	}
+
+void CmdButton::debounce(uint16_t lockout) {
+	mypin.lockout(lockout);
+	}
+
+uint32_t CmdButton::timestamp() {
+	return edgeTime;
 	}
 
 
-OscButton::OscButton(PinName pin, string pattern, int32_t integer32, uint8_t ip[], uint16_t port, protocol_t protocol ) : mypin(pin, PullUp) {
-	last = mypin;
+OscButton::OscButton(PinName pin, string pattern, int32_t integer32, uint8_t ip[], uint16_t port, protocol_t protocol ) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
 	address.set_ip_bytes(ip, NSAPI_IPv4);
 	address.set_port(port);
+	entry = -1;
+	targets = 0; // only its own destination
 	this->pattern = pattern;
 	this->integer32 = integer32;
 	type = INT32;
 	this->protocol = protocol;
 	}
 
-OscButton::OscButton(PinName pin, string pattern, float float32, uint8_t ip[], uint16_t port, protocol_t protocol ) : mypin(pin, PullUp) {
-	last = mypin;
+OscButton::OscButton(PinName pin, string pattern, float float32, uint8_t ip[], uint16_t port, protocol_t protocol ) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
 	address.set_ip_bytes(ip, NSAPI_IPv4);
 	address.set_port(port);
+	entry = -1;
+	targets = 0; // only its own destination
 	this->pattern = pattern;
 	this->float32 = float32;
 	type = FLOAT32;
 	this->protocol = protocol;
 	}
 
-OscButton::OscButton(PinName pin, string pattern, string msg, uint8_t ip[], uint16_t port, protocol_t protocol ) : mypin(pin, PullUp) {
-	last = mypin;
+OscButton::OscButton(PinName pin, string pattern, string msg, uint8_t ip[], uint16_t port, protocol_t protocol ) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
 	address.set_ip_bytes(ip, NSAPI_IPv4);
 	address.set_port(port);
+	entry = -1;
+	targets = 0; // only its own destination
 	this->pattern = pattern;
 	this->msg = msg;
 	type = STRING;
 	this->protocol = protocol;
 	}
 
-OscButton::OscButton(PinName pin, string pattern, flag_t flag, uint8_t ip[], uint16_t port, protocol_t protocol ) : mypin(pin, PullUp) {
-	last = mypin;
+OscButton::OscButton(PinName pin, string pattern, flag_t flag, uint8_t ip[], uint16_t port, protocol_t protocol ) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
 	address.set_ip_bytes(ip, NSAPI_IPv4);
 	address.set_port(port);
+	entry = -1;
+	targets = 0; // only its own destination
 	this->pattern = pattern;
 	this->flag = flag;
 	type = FLAG;
 	this->protocol = protocol;
 	}
 
-OscButton::OscButton(PinName pin, string pattern, uint8_t ip[], uint16_t port, protocol_t protocol ) : mypin(pin, PullUp) {
-	last = mypin;
+OscButton::OscButton(PinName pin, string pattern, uint8_t ip[], uint16_t port, protocol_t protocol ) : Control(BUTTON_UPDATE_RATE_MS), mypin(pin) {
+	edgeTime = 0;
 	address.set_ip_bytes(ip, NSAPI_IPv4);
 	address.set_port(port);
+	entry = -1;
+	targets = 0; // only its own destination
 	this->pattern = pattern;
 	type = NONE;
 	this->protocol = protocol;
 	}
 
+OscButton::~OscButton() {
+	if (entry >= 0) releaseDestination(entry);
+	}
+
 void OscButton::update() {
-	if (mypin != last) {
-		string oscPattern = pattern;
-		if (last == false) {
-			last = true;
-			if (type == INT32) {
-				message(oscPattern, (int32_t)0);
-				sendUDP(oscPattern, address);
-				return;
-				}
-			if (type == FLOAT32) {
-				message(oscPattern, 0.0f);
-				sendUDP(oscPattern, address);
-				return;
-				}
+	bool level;
+	counters.samples++;
+	counters.suppressed += mypin.bounces();
+	while (mypin.event(level, edgeTime)) {
+		char osc[OSC_MESSAGE_SIZE];
+		uint16_t length = 0;
+		if (level) {
+			// released
+			if (type == INT32) length = message(osc, sizeof(osc), pattern.c_str(), (int32_t)0);
+			if (type == FLOAT32) length = message(osc, sizeof(osc), pattern.c_str(), 0.0f);
+			if (length == 0) continue;
 			}
 		else {
-			last = false; // TODO case
 			switch (type) {
 				case INT32:
-					message(oscPattern, integer32, protocol);
+					length = message(osc, sizeof(osc), pattern.c_str(), integer32);
 					break;
 				case FLOAT32:
-					message(oscPattern, float32, protocol);
+					length = message(osc, sizeof(osc), pattern.c_str(), float32);
 					break;
 				case STRING:
-					message(oscPattern, msg, protocol);
+					length = message(osc, sizeof(osc), pattern.c_str(), msg.c_str());
 					break;
 				case FLAG:
-					message(oscPattern, flag, protocol);
+					length = message(osc, sizeof(osc), pattern.c_str(), flag);
 					break;
 				case NONE:
-					message(oscPattern, protocol);
+					length = message(osc, sizeof(osc), pattern.c_str());
 					break;
 				}
-			if (protocol == UDP) {
-				sendUDP(oscPattern,address);
-				return;
-				}
-			if ((protocol == TCP11) || (protocol == TCP10) || (protocol == TCP)) {
-				sendTCP(oscPattern, address);
-				}
-			//sendUDP(oscPattern, address);
 			}
+		// the address is an entry of the destination table, taken with the first message,
+		// so the buttons can be global objects
+		if (entry < 0) entry = shareDestination(address, protocol);
+		uint8_t to = targets | ((entry < 0) ? 0 : TARGET_CONSOLE << (entry + 1));
+		record(length && to && post(osc, length, protocol, KEEP, to), edgeTime);
 		}
-	} 
+	}
 
+void OscButton::label(char* buffer, uint16_t size) {
+	snprintf(buffer, size, "%s", pattern.c_str());
+	}
 
-void message(string& osc, int32_t value, protocol_t protocol) {
-	// fill pattern with zeros
-	uint8_t fill = 4 - osc.length() % 4;
-	for (uint8_t i = 0; i < fill; i++) {
-		osc += '\0';
-		}
-	// add type tag
-	osc += ",i";
-	osc += '\0';
-	osc += '\0';
-	// add value
-	uint8_t *int32Array = (uint8_t *) &value; // itoa
-	osc += int32Array[3];
-	osc += int32Array[2];
-	osc += int32Array[1];
-	osc += int32Array[0];
-	switch (protocol) {
-		case UDP:
-			break;
-		case TCP:
-			break;
-		case TCP10:
-			tcpEncode(osc);
-			break;
-		case TCP11:
-			slipEncode(osc);
-			break;
+void OscButton::debounce(uint16_t lockout) {
+	mypin.lockout(lockout);
+	}
+
+uint32_t OscButton::timestamp() {
+	return edgeTime;
+	}
+
+void renderPageBanks() {
+	for (PageBank* bank = pageBanks; bank; bank = bank->nextBank) {
+		for (uint8_t i = 0; i < bank->memberCount; i++) {
+			bank->render(i);
+			}
 		}
 	}
 
-void message(string& osc, float value, protocol_t protocol) {
-	// fill pattern with zeros
-	uint8_t fill = 4 - osc.length() % 4;
-	for (uint8_t i = 0; i < fill; i++) {
-		osc += '\0';
-		}
-	// add type tag
-	osc += ",f";
-	osc += '\0';
-	osc += '\0';
-	// add value
-	uint8_t *int32Array = (uint8_t *) &value; // itoa
-	osc += int32Array[3];
-	osc += int32Array[2];
-	osc += int32Array[1];
-	osc += int32Array[0];
-	switch (protocol) {
-		case UDP:
-			break;
-		case TCP:
-			break;
-		case TCP10:
-			tcpEncode(osc);
-			break;
-		case TCP11:
-			slipEncode(osc);
+PageBank::PageBank(uint16_t first, uint8_t count) {
+	this->first = first;
+	this->count = count ? count : 1;
+	index = 0;
+	memberCount = 0;
+	nextBank = pageBanks;
+	pageBanks = this;
+	}
+
+PageBank::~PageBank() {
+	// the controls go back to their own page and rebuild their packets
+	for (uint8_t i = 0; i < memberCount; i++) {
+		*members[i].active = nullptr;
+		*members[i].page = members[i].base;
+		OscPacket** held = members[i].held;
+		if (held && (*held >= packets) && (*held < packets + PAGE_BANK_PACKETS)) {
+			// a held key keeps a copy of its press, the release goes to the same page
+			*members[i].packet = **held;
+			*held = members[i].packet;
+			}
+		}
+	nameGeneration++;
+	for (PageBank** list = &pageBanks; *list; list = &(*list)->nextBank) {
+		if (*list == this) {
+			*list = nextBank;
 			break;
+			}
 		}
 	}
 
-void message(string& osc, string value, protocol_t protocol) {
-	// fill pattern with zeros
-	uint8_t fill = 4 - osc.length() % 4;
-	for (uint8_t i = 0; i < fill; i++) {
-		osc += '\0';
-		}
-	// add type tag
-	osc += ",s";
-	osc += '\0';
-	osc += '\0';
-	fill = 4 - value.length() % 4;
-	osc += value;
-	for (uint8_t i = 0; i < fill; i++) {
-		osc += '\0';
+bool PageBank::add(Fader& fader) {
+	return add(Member{&fader.active, &fader.page, &faderName, fader.key, fader.page, &fader, nullptr, nullptr});
+	}
+
+bool PageBank::add(Key& key) {
+	return add(Member{&key.active, &key.page, &keyName, key.key, key.page, nullptr, &key.held, &key.packet});
+	}
+
+bool PageBank::add(ExecutorKnob& executorKnob) {
+	return add(Member{&executorKnob.active, &executorKnob.page, &executorKnobName, executorKnob.executorKnob, executorKnob.page, nullptr, nullptr, nullptr});
+	}
+
+bool PageBank::add(const Member& member) {
+	if (memberCount >= PAGE_BANK_CONTROLS) return false;
+	if ((memberCount + 1) * count > PAGE_BANK_PACKETS) return false;
+	members[memberCount] = member;
+	render(memberCount);
+	memberCount++;
+	return true;
+	}
+
+void PageBank::render(uint8_t member) {
+	Member& entry = members[member];
+	char tag = (entry.fader && entry.fader->type == FLOAT32) ? 'f' : 'i';
+	for (uint8_t i = 0; i < count; i++) {
+		char pattern[OSC_PATTERN_SIZE];
+		if (executorPattern(pattern, sizeof(pattern), *entry.name, first + i, entry.number)) packets[member * count + i].build(pattern, tag);
+		else packets[member * count + i].clear();
 		}
-	switch (protocol) {
-		case UDP:
-			break;
-		case TCP:
-			break;
-		case TCP10:
-			tcpEncode(osc);
-			break;
-		case TCP11:
-			slipEncode(osc);
-			break;
+	*entry.active = &packets[member * count + index];
+	*entry.page = first + index;
+	}
+
+bool PageBank::select(uint16_t page) {
+	if (page < first || page >= first + count) return false;
+	index = page - first;
+	for (uint8_t i = 0; i < memberCount; i++) {
+		// one pointer per control, the packets are already rendered
+		*members[i].active = &packets[i * count + index];
+		*members[i].page = page;
+		if (members[i].fader) members[i].fader->resend();
 		}
+	return true;
 	}
 
-void message(string& osc, flag_t flag, protocol_t protocol) {
-	// fill pattern with zeros
-	uint8_t fill = 4 - osc.length() % 4;
-	for (uint8_t i = 0; i < fill; i++) {
-		osc += '\0';
-		}
-	// add type tag
-	osc += ",";
-	switch (flag) {
-		case T:
-			osc += 'T';
-		case F:
-			osc += 'F';
-		case N:
-			osc += 'N';
-		case I:
-			osc += 'I';
-		}
-	osc += '\0';
-	osc += '\0';
-	switch (protocol) {
-		case UDP:
-			break;
-		case TCP:
-			break;
-		case TCP10:
-			tcpEncode(osc);
-			break;
-		case TCP11:
-			slipEncode(osc);
-			break;
+uint16_t PageBank::selected() {
+	return first + index;
+	}
+
+
+bool OscPacket::build(const char* pattern, char tag) {
+	const char tags[2] = {tag, '\0'};
+	OscWriter osc(buffer, sizeof(buffer));
+	osc.begin(pattern, tags);
+	osc.add((int32_t)0);
+	size = osc.length();
+	return size != 0;
+	}
+
+void OscPacket::clear() {
+	size = 0;
+	}
+
+void OscPacket::set(int32_t value) {
+	if (size == 0) return;
+	oscStore32(buffer + size - 4, value);
+	}
+
+void OscPacket::set(float value) {
+	int32_t data;
+	memcpy(&data, &value, sizeof(data));
+	set(data);
+	}
+
+const char* OscPacket::data() {
+	return buffer;
+	}
+
+uint16_t OscPacket::length() {
+	return size;
+	}
+
+OscWriter::OscWriter(char* buffer, uint16_t size) {
+	this->buffer = buffer;
+	this->size = size;
+	position = 0;
+	error = false;
+	}
+
+void OscWriter::begin(const char* pattern, const char* tags) {
+	position = 0;
+	error = false;
+	size_t length = strlen(pattern);
+	char* address = string(length);
+	if (address) memcpy(address, pattern, length);
+	length = strlen(tags);
+	char* typeTags = string(length + 1);
+	if (typeTags == nullptr) return;
+	typeTags[0] = ',';
+	memcpy(typeTags + 1, tags, length);
+	}
+
+void OscWriter::begin(const char* pattern, char tag, uint8_t count) {
+	position = 0;
+	error = false;
+	size_t length = strlen(pattern);
+	char* address = string(length);
+	if (address) memcpy(address, pattern, length);
+	char* typeTags = string(count + 1);
+	if (typeTags == nullptr) return;
+	typeTags[0] = ',';
+	memset(typeTags + 1, tag, count);
+	}
+
+void OscWriter::add(int32_t value) {
+	put32((uint32_t)value);
+	}
+
+void OscWriter::add(float value) {
+	uint32_t data;
+	memcpy(&data, &value, sizeof(data));
+	put32(data);
+	}
+
+void OscWriter::add(const char* value) {
+	size_t length = strlen(value);
+	char* data = string(length);
+	if (data) memcpy(data, value, length);
+	}
+
+void OscWriter::add(int64_t value) {
+	put32((uint64_t)value >> 32);
+	put32((uint32_t)value);
+	}
+
+void OscWriter::add(double value) {
+	uint64_t data;
+	memcpy(&data, &value, sizeof(data));
+	add((int64_t)data);
+	}
+
+void OscWriter::add(const OscBlob& blob) {
+	addBlob(blob.data, blob.length);
+	}
+
+void OscWriter::add(const int32_t values[], uint8_t count) {
+	char* data = reserve(4 * count, 4 * count);
+	if (data == nullptr) return;
+	for (uint8_t i = 0; i < count; i++) {
+		oscStore32(data + 4 * i, values[i]);
 		}
 	}
 
-void message(string& osc, protocol_t protocol) {
-	// fill pattern with zeros
-	uint8_t fill = 4 - osc.length() % 4;
-	for (uint8_t i = 0; i < fill; i++) {
-		osc += '\0';
-		}
-	// add type tag
-	osc += ",";
-	osc += '\0';
-	osc += '\0';
-	osc += '\0';
+void OscWriter::add(const float values[], uint8_t count) {
+	char* data = reserve(4 * count, 4 * count);
+	if (data == nullptr) return;
+	for (uint8_t i = 0; i < count; i++) {
+		uint32_t value;
+		memcpy(&value, &values[i], sizeof(value));
+		oscStore32(data + 4 * i, value);
+		}
+	}
+
+void OscWriter::addBlob(const void* data, uint16_t length) {
+	// size, data and 0 to 3 zeros, computed wide, so a long blob can't wrap around
+	char* blob = reserve(4 + (size_t)length, 4 + (((size_t)length + 3) & ~(size_t)3));
+	if (blob == nullptr) return;
+	oscStore32(blob, length);
+	memcpy(blob + 4, data, length);
+	}
+
+void OscWriter::frame(protocol_t protocol) {
+	if (error) return;
+	uint16_t length = position;
 	switch (protocol) {
 		case UDP:
 			break;
 		case TCP:
 			break;
 		case TCP10:
-			tcpEncode(osc);
+			length = tcpEncode(buffer, position, size);
 			break;
 		case TCP11:
-			slipEncode(osc);
+			length = slipEncode(buffer, position, size);
 			break;
 		}
+	if (length == 0) error = true;
+	else position = length;
+	}
+
+uint16_t OscWriter::length() {
+	return error ? 0 : position;
+	}
+
+bool OscWriter::overflow() {
+	return error;
+	}
+
+/**
+ * @brief reserve space for data, the last word of the padding is cleared
+ * 
+ * @param length length of the data
+ * @param padded size with the padding, a multiple of 4
+ * @return char* space for the data, nullptr if the buffer is too small
+ */
+char* OscWriter::reserve(size_t length, size_t padded) {
+	if (error || (padded > (size_t)(size - position))) {
+		error = true;
+		return nullptr;
+		}
+	char* data = buffer + position;
+	if (padded > length) oscStore32(data + padded - 4, 0);
+	position += padded;
+	return data;
+	}
+
+/**
+ * @brief reserve space for a string, terminated with 1 to 4 zeros to fill up to 32 bit
+ * 
+ */
+char* OscWriter::string(size_t length) {
+	return reserve(length, (length / 4 + 1) * 4);
+	}
+
+void OscWriter::put32(uint32_t value) {
+	char* data = reserve(4, 4);
+	if (data) oscStore32(data, value);
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, int32_t value, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, "i");
+	osc.add(value);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, float value, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, "f");
+	osc.add(value);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const char* value, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, "s");
+	osc.add(value);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, flag_t flag, protocol_t protocol) {
+	const char tags[4][2] = {"T", "F", "N", "I"};
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, tags[flag]);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const int32_t values[], uint8_t count, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, 'i', count);
+	osc.add(values, count);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const float values[], uint8_t count, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, 'f', count);
+	osc.add(values, count);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const void* data, uint16_t length, protocol_t protocol) {
+	OscWriter osc(buffer, size);
+	osc.begin(pattern, "b");
+	osc.addBlob(data, length);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+/**
+ * @brief worst case size of a message, SLIP can double the size
+ * 
+ * @param pattern length of the address pattern
+ * @param argument length of the argument
+ * @return size_t size for the message buffer
+ */
+static size_t messageSize(size_t pattern, size_t argument) {
+	return 2 * (pattern + 4 + 4 + argument + 4 + 4) + 2;
+	}
+
+void message(string& osc, int32_t value, protocol_t protocol) {
+	string pattern = osc;
+	osc.resize(messageSize(pattern.length(), 4));
+	osc.resize(message(&osc[0], osc.length(), pattern.c_str(), value, protocol));
+	}
+
+void message(string& osc, float value, protocol_t protocol) {
+	string pattern = osc;
+	osc.resize(messageSize(pattern.length(), 4));
+	osc.resize(message(&osc[0], osc.length(), pattern.c_str(), value, protocol));
+	}
+
+void message(string& osc, string value, protocol_t protocol) {
+	string pattern = osc;
+	osc.resize(messageSize(pattern.length(), value.length()));
+	osc.resize(message(&osc[0], osc.length(), pattern.c_str(), value.c_str(), protocol));
+	}
+
+void message(string& osc, flag_t flag, protocol_t protocol) {
+	string pattern = osc;
+	osc.resize(messageSize(pattern.length(), 0));
+	osc.resize(message(&osc[0], osc.length(), pattern.c_str(), flag, protocol));
+	}
+
+void message(string& osc, protocol_t protocol) {
+	string pattern = osc;
+	osc.resize(messageSize(pattern.length(), 0));
+	osc.resize(message(&osc[0], osc.length(), pattern.c_str(), protocol));
 	}
 
 void slipEncode(string& msg) {
-	int length = msg.length();
-	for (int16_t i = length - 1; i >= 0; i--) {
+	// counted in size_t, a string has no 64 KB limit
+	size_t length = msg.length() + 2;
+	for (size_t i = 0; i < msg.length(); i++) {
+		if ((msg[i] == END) || (msg[i] == ESC)) length++;
+		}
+	string encoded(length, END);
+	size_t j = 1;
+	for (size_t i = 0; i < msg.length(); i++) {
+		if (msg[i] == END) {
+			encoded[j++] = ESC;
+			encoded[j++] = ESC_END;
+			}
+		else if (msg[i] == ESC) {
+			encoded[j++] = ESC;
+			encoded[j++] = ESC_ESC;
+			}
+		else {
+			encoded[j++] = msg[i];
+			}
+		}
+	msg.swap(encoded);
+	}
+
+uint32_t slipLength(const char* msg, uint16_t length) {
+	uint32_t encoded = length + 2;
+	for (uint16_t i = 0; i < length; i++) {
+		if ((msg[i] == END) || (msg[i] == ESC)) encoded++;
+		}
+	return encoded;
+	}
+
+uint16_t slipEncode(char* msg, uint16_t length, uint16_t size) {
+	// encode backwards in place, the encoded message is never shorter
+	uint32_t encoded = slipLength(msg, length);
+	if (encoded > size) return 0;
+	int32_t j = encoded - 1;
+	msg[j--] = END;
+	for (int32_t i = length - 1; i >= 0; i--) {
 		if (msg[i] == END) {
-			msg[i] = ESC_END;
-			msg.insert(i, 1, ESC);
+			msg[j--] = ESC_END;
+			msg[j--] = ESC;
+			}
+		else if (msg[i] == ESC) {
+			msg[j--] = ESC_ESC;
+			msg[j--] = ESC;
+			}
+		else {
+			msg[j--] = msg[i];
+			}
 		}
+	msg[0] = END;
+	return encoded;
+	}
+
+uint16_t slipEncode(const char* msg, uint16_t length, char* out, uint16_t size) {
+	uint16_t j = 0;
+	if (size < 2) return 0;
+	out[j++] = END;
+	for (uint16_t i = 0; i < length; i++) {
+		// keep space for the closing END
+		if (msg[i] == END) {
+			if (size - j < 3) return 0;
+			out[j++] = ESC;
+			out[j++] = ESC_END;
+			}
 		else if (msg[i] == ESC) {
-			msg[i] = ESC_ESC;
-			msg.insert(i, 1, ESC);
+			if (size - j < 3) return 0;
+			out[j++] = ESC;
+			out[j++] = ESC_ESC;
+			}
+		else {
+			if (size - j < 2) return 0;
+			out[j++] = msg[i];
+			}
 		}
+	out[j++] = END;
+	return j;
 	}
-	msg.insert(0, 1, END);
-	msg += END;
-}
 
 void slipDecode(string& msg) {
-	bool flagESC = false;
-	bool flagEND = false;
-	int length = msg.length();
-	for (int16_t i = length - 1; i >= 0; i--) {
-		if (msg[i] == END) {
-			msg.erase(i, 1);
+	// in place, the decoded message is never longer
+	size_t j = 0;
+	bool escape = false;
+	for (size_t i = 0; i < msg.length(); i++) {
+		char c = msg[i];
+		if (c == END) continue;
+		if (escape) {
+			escape = false;
+			if (c == ESC_END) c = END;
+			else if (c == ESC_ESC) c = ESC;
+			}
+		else if (c == ESC) {
+			escape = true;
+			continue;
+			}
+		msg[j++] = c;
 		}
-		if (msg[i] == ESC_END) {
-			flagEND = true;
+	msg.resize(j);
+	}
+
+uint16_t slipDecode(const char* msg, uint16_t length, char* out, uint16_t size) {
+	// the decoded message is never longer, so out can be msg
+	uint16_t j = 0;
+	bool escape = false;
+	for (uint16_t i = 0; i < length; i++) {
+		char c = msg[i];
+		if (c == END) continue;
+		if (escape) {
+			escape = false;
+			if (c == ESC_END) c = END;
+			else if (c == ESC_ESC) c = ESC;
+			}
+		else if (c == ESC) {
+			escape = true;
+			continue;
+			}
+		if (j >= size) return 0;
+		out[j++] = c;
 		}
-		if (msg[i] == ESC_ESC) {
-			flagESC = true;
+	return j;
+	}
+
+SlipDecoder::SlipDecoder(char* buffer, uint16_t size) {
+	this->buffer = buffer;
+	this->size = size;
+	position = 0;
+	drops = 0;
+	escape = false;
+	overflow = false;
+	complete = false;
+	}
+
+uint16_t SlipDecoder::decode(const char* data, uint16_t length) {
+	if (complete) {
+		complete = false;
+		position = 0;
 		}
-		if (msg[i] == ESC) {
-			if (flagEND) {
-				msg.erase(i + 1, 1);
-				msg[i] = END;
-				flagEND = false;
+	for (uint16_t i = 0; i < length; i++) {
+		char c = data[i];
+		if (c == END) {
+			if (overflow) {
+				drops++;
+				overflow = false;
+				position = 0;
+				}
+			else if (position > 0) {
+				complete = true;
+				}
+			escape = false;
+			if (complete) return i + 1;
+			continue;
+			}
+		if (escape) {
+			escape = false;
+			if (c == ESC_END) c = END;
+			else if (c == ESC_ESC) c = ESC;
 			}
-			if (flagESC) {
-				msg.erase(i + 1, 1);
-				msg[i] = ESC;
-				flagESC = false;
+		else if (c == ESC) {
+			escape = true;
+			continue;
 			}
+		if (position < size) buffer[position++] = c;
+		else overflow = true;
 		}
+	return length;
+	}
+
+bool SlipDecoder::available() {
+	return complete;
+	}
+
+const char* SlipDecoder::data() {
+	return buffer;
+	}
+
+uint16_t SlipDecoder::length() {
+	return complete ? position : 0;
+	}
+
+uint32_t SlipDecoder::dropped() {
+	return drops;
 	}
-}
 
 void tcpEncode(string& msg) {
 	int32_t length = msg.length();
@@ -526,6 +2825,75 @@ void tcpEncode(string& msg) {
 	msg.insert(0, 1, int32Array[3]);
 };
 
+uint16_t tcpEncode(char* msg, uint16_t length, uint16_t size) {
+	if ((uint32_t)length + 4 > size) return 0;
+	memmove(msg + 4, msg, length);
+	oscStore32(msg, length);
+	return length + 4;
+	}
+
+TcpDecoder::TcpDecoder(char* buffer, uint16_t size) {
+	this->buffer = buffer;
+	this->size = size;
+	expected = 0;
+	position = 0;
+	header = 0;
+	drops = 0;
+	complete = false;
+	}
+
+uint16_t TcpDecoder::decode(const char* data, uint16_t length) {
+	if (complete) {
+		complete = false;
+		header = 0;
+		expected = 0;
+		position = 0;
+		}
+	uint16_t i = 0;
+	while (i < length) {
+		if (header < 4) {
+			// big endian length
+			expected = (expected << 8) | (uint8_t)data[i++];
+			header++;
+			if ((header == 4) && (expected == 0)) header = 0;
+			continue;
+			}
+		uint32_t chunk = expected - position;
+		if (chunk > (uint32_t)(length - i)) chunk = length - i;
+		// frames larger than the buffer are skipped
+		if (position + chunk <= size) memcpy(buffer + position, data + i, chunk);
+		position += chunk;
+		i += chunk;
+		if (position == expected) {
+			if (expected <= size) {
+				complete = true;
+				return i;
+				}
+			drops++;
+			header = 0;
+			expected = 0;
+			position = 0;
+			}
+		}
+	return i;
+	}
+
+bool TcpDecoder::available() {
+	return complete;
+	}
+
+const char* TcpDecoder::data() {
+	return buffer;
+	}
+
+uint16_t TcpDecoder::length() {
+	return complete ? position : 0;
+	}
+
+uint32_t TcpDecoder::dropped() {
+	return drops;
+	}
+
 void tcpDecode(string& msg) {
 	msg.erase(0, 4);
 };
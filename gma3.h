@@ -24,9 +24,9 @@ THE SOFTWARE.
 #ifndef GMA3_H
 #define GMA3_H
 
-#include "mbed.h"
+#include "gma3_hal.h"
+#include "gma3_osc.h"
 #include <string>
-#include "EthernetInterface.h"
 
 using namespace std;
 
@@ -41,9 +41,90 @@ using namespace std;
 #define FORWARD  0
 #define REVERSE  1
 
+// scheduler settings
+#define SCHEDULER_TICK_US       1000 // resolution of the timing wheel
+#define SCHEDULER_SLOTS         64 // slots of the timing wheel, a power of 2
+#define BUTTON_UPDATE_RATE_MS   1 // poll period of Key, CmdButton and OscButton
+#define ENCODER_UPDATE_RATE_MS  1 // poll period of the ExecutorKnob counter
+
+// button settings
+#define DEBOUNCE_LOCKOUT_MS  5 // edges after an accepted edge are ignored for
+#define DEBOUNCE_EVENTS      8 // clean edges buffered between two updates
+
+// key matrix settings
+#define KEY_MATRIX_KEYS       256 // maximum number of keys of a KeyMatrix
+#define KEY_MATRIX_ROWS       16 // maximum number of rows of a direct matrix
+#define KEY_MATRIX_COLUMNS    16 // maximum number of columns of a direct matrix
+#define KEY_MATRIX_PERIOD_US  500 // background scan period, a direct matrix scans one row per period
+
+// diagnostic settings
+#define STATS_BUCKETS  16 // latency histogram, bucket n counts latencies below 2^n us
+#define STATS_ADDRESS  "/gma3/diagnostics" // OSC address of reportControls()
+
+// profiling settings
+#ifndef GMA3_PROFILE
+#define GMA3_PROFILE  0 // 1 measures the cost of each update() and send, e.g. with -DGMA3_PROFILE=1
+#endif
+#define PROFILE_BUCKETS      112 // histogram buckets, 4 per octave, the last counts all above 2^28 cycles
+#define PROFILE_INTERVAL_MS  1000 // default period of the profile reports
+#define PROFILE_ADDRESS      "/gma3/profile" // OSC address of the profile reports
+
+// page bank settings
+#define PAGE_BANK_CONTROLS  32 // maximum number of controls of a PageBank
+#define PAGE_BANK_PACKETS   64 // pre-rendered packets of a PageBank, controls * pages
+
+// encoder settings
+#define ENCODER_STEPS         4 // quadrature steps per detent
+#define ENCODER_ACCELERATION  1000 // divider of speed (detents/s) * acceleration factor
+
 // fader settings
 #define FADER_UPDATE_RATE_MS  40 // update each 40ms
 #define FADER_THRESHOLD       4 // Jitter threshold of the faders
+#define FADER_SETTLE_MS       250 // adaptive hysteresis widens after the fader rests for
+#define FADER_AVERAGE_SIZE    16 // maximum length of an AverageFilter
+#define FADER_BANK_CHANNELS   16 // maximum number of faders of a FaderBank
+#define FADER_BANK_PERIOD_US  1000 // background scan period of a FaderBank
+
+// motor fader settings
+#define MOTOR_FADER_PERIOD_US   1000 // period of the position control loop
+#define MOTOR_FADER_PWM_US      50 // PWM period of the motor driver, 20 kHz
+#define MOTOR_FADER_DEADBAND    (2 << 6) // the motor stops within 2 of 1024 steps of the target
+#define MOTOR_FADER_TIMEOUT_MS  1000 // the motor stops if the target isn't reached, e.g. blocked
+#define MOTOR_FADER_MIN_DUTY    0.25f // duty cycle which just moves the knob
+#define MOTOR_FADER_KP          6.0f // standard gains of the PID controller, error and output 0.0...1.0
+#define MOTOR_FADER_KI          0.0f
+#define MOTOR_FADER_KD          20.0f
+
+// OSC settings
+#define OSC_MESSAGE_SIZE  256 // maximum size of an encoded OSC message
+#define OSC_PATTERN_SIZE  64 // maximum size of an OSC address pattern
+#define OSC_PACKET_SIZE   72 // size of a cached message with a single 32 bit argument
+#define OSC_RECEIVE_SIZE  1472 // maximum size of a received message or bundle
+#define OSC_ARGUMENTS     16 // maximum number of parsed arguments of a received message
+#define OSC_HANDLERS      32 // maximum number of receive handlers
+
+// TCP settings
+#define TCP_QUEUE_SIZE          1024 // bytes of frames queued while connecting
+#define TCP_CONNECTIONS         4 // maximum number of extern TCP destinations
+#define TCP_CONNECT_TIMEOUT_MS  1000 // give up a pending connect after
+#define TCP_BACKOFF_MIN_MS      50 // first reconnect delay
+#define TCP_BACKOFF_MAX_MS      5000 // reconnect delay doubles up to
+
+// bundle settings
+#define BUNDLE_SIZE         1472 // UDP bundle size, Ethernet MTU without IP and UDP header
+#define BUNDLE_TCP_SIZE     480 // TCP bundle size, SLIP framed it must fit into TCP_QUEUE_SIZE
+#define BUNDLE_DEADLINE_MS  10 // maximum time a message waits in a bundle
+
+// network thread settings
+#define QUEUE_SLOTS         16 // messages in the outbound queue
+#define NETWORK_STACK_SIZE  4096 // stack of the network thread
+#define NETWORK_IDLE_MS     10 // the network thread updates the TCP connections at least every
+#define COALESCE_INTERVAL_MS  5 // pending messages are sent at least every
+
+// destination settings
+#define DESTINATIONS    4 // entries of the destination table, maximum 7
+#define TARGET_CONSOLE  0x01 // target bit of the console, destination n has the bit 1 << (n + 1)
+#define TARGET_ALL      0xFF // the console and all destinations
 
 // defines for SLIP
 const char END = 0xC0; // indicates end of packet
@@ -58,6 +139,12 @@ typedef enum protocolType {
 	TCP
 	} protocol_t;
 
+typedef enum connectionState {
+	DISCONNECTED,
+	CONNECTING,
+	CONNECTED
+	} connection_t;
+
 typedef enum oscType {
 	NONE,
 	INT32,
@@ -66,6 +153,12 @@ typedef enum oscType {
 	FLAG,
 	} osc_t;
 
+typedef enum coalesceType {
+	KEEP, // every message is sent
+	LATEST, // a newer message replaces the pending one with the same address
+	SUM // the int32 argument of a newer message is added to the pending one
+	} coalesce_t;
+
 typedef enum flagType {
 	T,
 	F,
@@ -73,6 +166,15 @@ typedef enum flagType {
 	I
 	} flag_t;
 
+class OscReader;
+class PageBank;
+
+/**
+ * @brief receive handler, called with the parsed message
+ * 
+ */
+typedef void (*osc_callback_t)(OscReader& msg, void* context);
+
 void interfaceETH(uint8_t localIP[], uint8_t subnet[]);
 
 /**
@@ -80,8 +182,9 @@ void interfaceETH(uint8_t localIP[], uint8_t subnet[]);
  * 
  * @param gam3IP GrandMA3 console IP address
  * @param gma3UdpPort UDP interface
+ * @param localUdpPort local port for receiving messages from the console, 0 for send only
  */
-void interfaceUDP(uint8_t gma3IP[], uint16_t gma3UdpPort = 8000);
+void interfaceUDP(uint8_t gma3IP[], uint16_t gma3UdpPort = 8000, uint16_t localUdpPort = 0);
 
 /**
  * @brief set TCP interface
@@ -97,8 +200,19 @@ void interfaceTCP(uint8_t gma3IP[], uint16_t gma3TcpPort = 9000);
  * @param msg OSC message
  * @param address SocketAddress for generic OSC buttons
  */
-void sendUDP(string& msg);
-void sendUDP(string& msg, SocketAddress address);
+bool sendUDP(string& msg);
+bool sendUDP(string& msg, SocketAddress address);
+
+/**
+ * @brief send an encoded OSC message buffer via UDP
+ * 
+ * @param msg OSC message buffer
+ * @param length length of the message
+ * @param address SocketAddress for generic OSC buttons
+ * @return true if the message was sent
+ */
+bool sendUDP(const char* msg, uint16_t length);
+bool sendUDP(const char* msg, uint16_t length, SocketAddress address);
 
 /**
  * @brief send an OSC message via TCP
@@ -106,8 +220,179 @@ void sendUDP(string& msg, SocketAddress address);
  * @param msg OSC message
  * @param address SocketAddress for generic OSC buttons
  */
-void sendTCP(string& msg);
-void sendTCP(string& msg, SocketAddress address);
+bool sendTCP(string& msg);
+bool sendTCP(string& msg, SocketAddress address);
+
+/**
+ * @brief send an encoded OSC message buffer via TCP
+ * 
+ * @param msg OSC message buffer
+ * @param length length of the message
+ * @param address SocketAddress for generic OSC buttons
+ * @return true if the message was sent or queued
+ */
+bool sendTCP(const char* msg, uint16_t length);
+bool sendTCP(const char* msg, uint16_t length, SocketAddress address);
+
+/**
+ * @brief keep the TCP connections alive, reconnect and send queued messages, should be in loop()
+ * 
+ */
+void updateTCP();
+
+/**
+ * @brief state of the TCP connection to the GrandMA3 console
+ * 
+ * @return connection_t DISCONNECTED, CONNECTING or CONNECTED
+ */
+connection_t stateTCP();
+
+/**
+ * @brief number of messages dropped by the TCP connection to the GrandMA3 console
+ * 
+ * @return uint32_t dropped messages
+ */
+uint32_t droppedTCP();
+
+/**
+ * @brief update all controls which are due, the controls are kept in a timing wheel
+ * and only visited when their period is over, replaces the update() calls in loop()
+ * 
+ */
+void updateControls();
+
+/**
+ * @brief collect messages to the GrandMA3 console into OSC bundles,
+ * a bundle is sent when it is full, older than the deadline or with flushBundle()
+ * 
+ * @param enable true to enable batching, false sends the pending bundles and disables batching
+ * @param deadline maximum time in ms a message waits in a bundle
+ */
+void bundle(bool enable, uint16_t deadline = BUNDLE_DEADLINE_MS);
+
+/**
+ * @brief send the pending bundles, should be at the end of loop()
+ * 
+ */
+void flushBundle();
+
+/**
+ * @brief send the messages of the controls from a network thread, the controls only
+ * queue their messages and never wait for the network, bundles are sent by the thread
+ * 
+ * @param enable true starts the thread, false stops it
+ */
+void networkThread(bool enable = true);
+
+/**
+ * @brief number of messages dropped by a full outbound queue
+ * 
+ * @return uint32_t dropped messages
+ */
+uint32_t droppedQueue();
+
+/**
+ * @brief add a destination which gets a copy of the messages of the controls,
+ * e.g. a backup console or a logging host, the messages are encoded once and only framed per destination,
+ * bundles are only sent to the console
+ * 
+ * @param ip IP address of the destination
+ * @param port port of the destination
+ * @param protocol framing of the destination, UDP, TCP, TCP10 or TCP11
+ * @param rate token bucket rate in messages/s, 0 is unlimited
+ * @param burst token bucket size in messages
+ * @return int8_t index of the destination, -1 if the table is full
+ */
+int8_t destination(uint8_t ip[], uint16_t port, protocol_t protocol = UDP, uint16_t rate = 0, uint16_t burst = 1);
+
+/**
+ * @brief remove a destination
+ * 
+ * @param index index of the destination
+ */
+void removeDestination(int8_t index);
+
+/**
+ * @brief messages which exceeded the rate limit of a destination
+ * 
+ * @param index index of the destination
+ * @return uint32_t dropped messages
+ */
+uint32_t destinationDropped(int8_t index);
+
+/**
+ * @brief coalesce the messages of the controls by their OSC address, pending values of faders
+ * are replaced by the latest one, encoder steps are summed up and keys keep every edge,
+ * the messages are sent once per interval by updateControls() or the network thread
+ * 
+ * @param enable true to enable coalescing, false sends the pending messages
+ * @param interval flush interval in ms
+ */
+void coalesce(bool enable, uint16_t interval = COALESCE_INTERVAL_MS);
+
+/**
+ * @brief send the counters of all controls to a diagnostic host, one UDP message per control
+ * to STATS_ADDRESS with the arguments: label, samples, sends, suppressed, failures and
+ * the STATS_BUCKETS latency buckets
+ * 
+ * @param ip IP address of the diagnostic host
+ * @param port port of the diagnostic host
+ */
+void reportControls(uint8_t ip[], uint16_t port);
+
+#if GMA3_PROFILE
+/**
+ * @brief send the profile periodically from updateControls(), one UDP message per probe
+ * to PROFILE_ADDRESS with the arguments: label, count, min, mean, p99 and max in ns,
+ * the probes are "loop" (one updateControls() pass), "period" (time between two passes),
+ * "udp" and "tcp" (each delivery of a control message, framing included, the network thread
+ * reports them while it runs) and each control, all probes are cleared after a report
+ * 
+ * @param ip IP address of the profiling host
+ * @param port port of the profiling host, 0 stops the reports
+ * @param interval report period in ms
+ */
+void profileReport(uint8_t ip[], uint16_t port, uint16_t interval = PROFILE_INTERVAL_MS);
+#endif
+
+/**
+ * @brief register a handler for received messages with an OSC address,
+ * the handlers are sorted for a binary search, no memory is allocated
+ * 
+ * @param pattern OSC address, the string must stay valid, e.g. a string literal
+ * @param callback handler function
+ * @param context optional pointer given to the handler
+ * @return true if the handler was registered, false if the table is full
+ */
+bool oscHandler(const char* pattern, osc_callback_t callback, void* context = nullptr);
+
+/**
+ * @brief remove the handler of an OSC address
+ * 
+ * @param pattern OSC address
+ */
+void removeOscHandler(const char* pattern);
+
+/**
+ * @brief parse a message or bundle and call the registered handlers
+ * 
+ * @param msg unframed message or bundle
+ * @param length length of the message
+ */
+void dispatch(const char* msg, uint16_t length);
+
+/**
+ * @brief receive messages from the console on the localUdpPort of interfaceUDP(), non blocking, should be in loop()
+ * 
+ */
+void receiveUDP();
+
+/**
+ * @brief receive messages from the console on the TCP connection, non blocking, should be in loop()
+ * 
+ * @param protocol framing of the received messages, TCP, TCP10 or TCP11
+ */
+void receiveTCP(protocol_t protocol = TCP);
 
 /**
  * @brief set the Prefix name
@@ -146,225 +431,1820 @@ void key(string key);
 
 
 /**
- * @brief Key object
+ * @brief OscWriter object, encodes OSC messages in place into a fixed size buffer without using the heap
  * 
  */
-class Key {
+class OscWriter {
 
 	public:
 
 		/**
-		 * @brief Construct a new Key object
+		 * @brief Construct a new OscWriter object
 		 * 
-		 * @param pin button pin
-		 * @param page number of the page
-		 * @param key number of the executor button
-		 * @param protocol type of the used protocol, UDP or TCP
+		 * @param buffer destination buffer, static or on the stack
+		 * @param size size of the buffer
 		 */
-		Key(PinName pin, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+		OscWriter(char* buffer, uint16_t size);
 
 		/**
-		 * @brief update the state of the Key button, must in loop()
+		 * @brief start a new message with address pattern and type tags
 		 * 
+		 * @param pattern OSC address
+		 * @param tags type tags without the leading ',', e.g. "i", "f", "s", "T" or ""
 		 */
-		void update();
+		void begin(const char* pattern, const char* tags = "");
 
-	private:
+		/**
+		 * @brief start a new message with the same type tag for all arguments, e.g. ",iiii"
+		 * 
+		 * @param pattern OSC address
+		 * @param tag type tag
+		 * @param count number of arguments
+		 */
+		void begin(const char* pattern, char tag, uint8_t count);
 
-		DigitalIn mypin;
-		protocol_t protocol;
-		uint16_t page;
-		uint16_t key;
-  	bool last;
+		/**
+		 * @brief add an argument, must match the type tags given in begin()
+		 * 
+		 * @param value integer32, float, string value
+		 */
+		void add(int32_t value);
+		void add(float value);
+		void add(const char* value);
+		void add(int64_t value);
+		void add(double value);
+		void add(const OscBlob& blob);
 
-	};
+		/**
+		 * @brief encode a complete message, the type tags are taken from the argument types,
+		 * e.g. message("/mix", (int32_t)1, 0.5f, "name") gives ",ifs"
+		 * 
+		 * @param pattern OSC address
+		 * @param args arguments, integers ('i' or 'h'), float, double, const char* or OscBlob
+		 */
+		template <typename... Args>
+		void message(const char* pattern, Args... args) {
+			const char tags[] = {OscTag<Args>::tag..., '\0'};
+			begin(pattern, tags);
+			int expand[] = {0, (add((typename OscTag<Args>::type)args), 0)...};
+			(void)expand;
+			}
 
+		/**
+		 * @brief add many arguments in one pass
+		 * 
+		 * @param values integer32 or float values
+		 * @param count number of values
+		 */
+		void add(const int32_t values[], uint8_t count);
+		void add(const float values[], uint8_t count);
 
-/**
- * @brief Fader object
- * 
- */
-class Fader {
+		/**
+		 * @brief add a blob argument, type tag 'b'
+		 * 
+		 * @param data blob data
+		 * @param length length of the data
+		 */
+		void addBlob(const void* data, uint16_t length);
 
-	public:
+		/**
+		 * @brief apply the protocol framing to the message, TCP10 length prefix or TCP11 SLIP
+		 * 
+		 * @param protocol type of the used protocol
+		 */
+		void frame(protocol_t protocol);
 
 		/**
-		 * @brief Construct a new Fader object
+		 * @brief length of the encoded message
 		 * 
-		 * @param pin fader leveler pin
-		 * @param page number of the page
-		 * @param key number of the executor button
-		 * @param protocol type of the used protocol, UDP or TCP
+		 * @return uint16_t length, 0 if the buffer was too small
 		 */
-		Fader(PinName pin, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+		uint16_t length();
 
 		/**
-		 * @brief update the state of the Key button, must in loop()
+		 * @brief check if the message didn't fit into the buffer
 		 * 
+		 * @return true if overflowed
 		 */
-		void update();
+		bool overflow();
 
 	private:
 
-		AnalogIn mypin;
-		protocol_t protocol;
-		uint16_t page;
-		uint16_t key;
-		int16_t analogLast;
-		uint32_t valueLast;
-		uint32_t updateTime;
+		char* buffer;
+		uint16_t size;
+		uint16_t position;
+		bool error;
+		char* reserve(size_t length, size_t padded);
+		char* string(size_t length);
+		void put32(uint32_t value);
 
 	};
 
 
 /**
- * @brief ExecutorKnob object
+ * @brief OscPacket object, a prebuilt message with a single 32 bit argument,
+ * sending only patches the argument
  * 
  */
-class ExecutorKnob {
+class OscPacket {
 
 	public:
 
 		/**
-		 * @brief Construct a new ExecutorKnob object
+		 * @brief build the padded address and type tag header
 		 * 
-		 * @param pinA pin A of the encoder
-		 * @param pinB pin B of the encoder
-		 * @param page number of the page
-	 	 * @param executorKnob number of the executorKnob
-		 * @param direction the direction for the encoder, can be FORWARD or REVERSE, depends on hardware alignment
-		 * @param protocol type of the used protocol, UDP or TCP
+		 * @param pattern OSC address
+		 * @param tag type tag of the argument, 'i' or 'f'
+		 * @return true if the message fits into the packet
 		 */
-		ExecutorKnob(PinName pinA, PinName pinB, uint16_t page, uint16_t executorKnob, uint8_t direction = FORWARD, protocol_t protocol = UDP);
+		bool build(const char* pattern, char tag = 'i');
 
 		/**
-		 * @brief update the output of the executorKnob, must be in loop()
+		 * @brief remove the message, a cleared packet has length 0 and isn't sent
 		 * 
 		 */
-		void update();
-	
+		void clear();
+
+		/**
+		 * @brief patch the argument
+		 * 
+		 * @param value integer32 or float value
+		 */
+		void set(int32_t value);
+		void set(float value);
+
+		/**
+		 * @brief the encoded message
+		 * 
+		 * @return const char* message data
+		 */
+		const char* data();
+
+		/**
+		 * @brief length of the encoded message
+		 * 
+		 * @return uint16_t length, 0 if the packet is not build
+		 */
+		uint16_t length();
+
 	private:
 
-		DigitalIn mypinA;
-		DigitalIn mypinB;
-		protocol_t protocol;
-		uint16_t page;
-		uint16_t executorKnob;
-		bool pinALast;
-		bool pinACurrent;
-		uint8_t direction;
-		int8_t encoderMotion;
+		char buffer[OSC_PACKET_SIZE];
+		uint8_t size = 0;
 
 	};
 
 
 /**
- * @brief CndButton object
+ * @brief OscReader object, parses a received message without copying,
+ * address and arguments point into the receive buffer
  * 
  */
-class CmdButton {
+class OscReader {
 
 	public:
 
 		/**
-		 * @brief Construct a new CmdButton object
+		 * @brief parse a message
 		 * 
-		 * @param pin button pin
-		 * @param command string to command line
-		 * @param protocol type of the used protocol, UDP or TCP
+		 * @param msg unframed message, must stay valid while reading
+		 * @param length length of the message
+		 * @return true if the message is valid
 		 */
-		CmdButton(PinName pin, string command, protocol_t protocol = UDP);
+		bool parse(const char* msg, uint16_t length);
 
 		/**
-		 * @brief update the state of the Key button, must in loop()
+		 * @brief OSC address of the message
 		 * 
+		 * @return const char* address
 		 */
-		void update();
+		const char* address();
+
+		/**
+		 * @brief type tags of the message without the leading ','
+		 * 
+		 * @return const char* type tags
+		 */
+		const char* tags();
+
+		/**
+		 * @brief number of arguments
+		 * 
+		 * @return uint8_t number of arguments
+		 */
+		uint8_t count();
+
+		/**
+		 * @brief type tag of an argument
+		 * 
+		 * @param index number of the argument
+		 * @return char type tag, '\0' if there is no argument
+		 */
+		char type(uint8_t index);
+
+		/**
+		 * @brief get an argument, numbers are converted between int and float
+		 * 
+		 * @param index number of the argument
+		 * @return value of the argument, 0 or nullptr if the type doesn't match
+		 */
+		int32_t getInt(uint8_t index);
+		float getFloat(uint8_t index);
+		const char* getString(uint8_t index);
+		bool getBool(uint8_t index);
+		const char* getBlob(uint8_t index, uint16_t& length);
+		int64_t getInt64(uint8_t index);
+		double getDouble(uint8_t index);
 
 	private:
 
-		DigitalIn mypin;
-		protocol_t protocol;
-		string command;
-  	bool last;
+		const char* pattern;
+		const char* typeTags;
+		uint8_t arguments;
+		const char* values[OSC_ARGUMENTS];
 
 	};
 
 
 /**
- * @brief osc button object
+ * @brief OscBundle object, collects messages into an OSC bundle with an immediate timetag
  * 
  */
-class OscButton {
+class OscBundle {
 
 	public:
 
 		/**
-		 * @brief Construct a new Key object
+		 * @brief Construct a new OscBundle object
 		 * 
-		 * @param pin button pin
-		 * @param pattern OSC address
-		 * @param integer32 optional integer value, must cast (int32_t) when using with a non matching size
-		 * @param float32 optional float value
-		 * @param msg optional string message
-		 * @param flag optiona flag
-		 * @param ip destination IP address
-		 * @param externPort destination port
+		 * @param buffer bundle buffer
+		 * @param size size of the bundle buffer
 		 */
-		OscButton(PinName pin, string pattern, int32_t integer32, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
-		OscButton(PinName pin, string pattern, float float32, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
-		OscButton(PinName pin, string pattern, string msg, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
-		OscButton(PinName pin, string pattern, flag_t flag, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
-		OscButton(PinName pin, string pattern, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
+		OscBundle(char* buffer, uint16_t size);
 
 		/**
-		 * @brief update the state of the Key button, must in loop()
+		 * @brief add an unframed message
 		 * 
+		 * @param msg message buffer
+		 * @param length length of the message
+		 * @return true if the message was added, false if the bundle is full
 		 */
-		void update();
+		bool add(const char* msg, uint16_t length);
+
+		/**
+		 * @brief remove all messages
+		 * 
+		 */
+		void clear();
+
+		/**
+		 * @brief number of messages in the bundle
+		 * 
+		 * @return uint16_t number of messages
+		 */
+		uint16_t count();
+
+		/**
+		 * @brief time since the first message was added
+		 * 
+		 * @return uint32_t age in us
+		 */
+		uint32_t age();
+
+		/**
+		 * @brief the encoded bundle, a single message is returned without the bundle header
+		 * 
+		 * @return const char* bundle data
+		 */
+		const char* data();
+
+		/**
+		 * @brief length of the encoded bundle
+		 * 
+		 * @return uint16_t length
+		 */
+		uint16_t length();
 
 	private:
 
-		SocketAddress address;
-		DigitalIn mypin;
-		protocol_t protocol;
-		string pattern;
-		string msg;
-		int32_t integer32;
-		float float32;
-		flag_t flag;
-		osc_t type;
-  	bool last;
+		char* buffer;
+		uint16_t size;
+		uint16_t position;
+		uint16_t messages;
+		uint32_t startTime;
 
 	};
 
+
 /**
- * @brief Creates osc messages with different data types
+ * @brief TcpConnection object, keeps a long lived TCP connection to one destination,
+ * reconnects with exponential backoff and queues messages meanwhile
  * 
- * @param osc message
- * @param value integer32, float, string value
- * @param flag type value
  */
-void message(string& osc, int32_t value, protocol_t protocol = UDP);
-void message(string& osc, float value, protocol_t protocol = UDP);
-void message(string& osc, string value, protocol_t protocol = UDP);
-void message(string& osc, flag_t flag, protocol_t protocol = UDP);
-void message(string& osc, protocol_t protocol = UDP);
+class TcpConnection {
 
-/**
- * @brief Encode messages with SLIP
+	public:
+
+		/**
+		 * @brief Construct a new TcpConnection object
+		 * 
+		 */
+		TcpConnection();
+
+		/**
+		 * @brief set the destination, the connection is opened with the next update()
+		 * 
+		 * @param interface network interface
+		 * @param address destination address
+		 */
+		void begin(NetworkInterface* interface, SocketAddress address);
+
+		/**
+		 * @brief close the connection and free it for another destination, queued messages are discarded
+		 * 
+		 */
+		void end();
+
+		/**
+		 * @brief queue an encoded message and send it as soon as possible
+		 * 
+		 * @param msg message buffer
+		 * @param length length of the message
+		 * @return true if the message was queued, false if it was dropped
+		 */
+		bool send(const char* msg, uint16_t length);
+
+		/**
+		 * @brief receive bytes from the connection, non blocking
+		 * 
+		 * @param data receive buffer
+		 * @param size size of the receive buffer
+		 * @return uint16_t number of received bytes
+		 */
+		uint16_t receive(char* data, uint16_t size);
+
+		/**
+		 * @brief connect, reconnect and send queued messages
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief state of the connection
+		 * 
+		 * @return connection_t DISCONNECTED, CONNECTING or CONNECTED
+		 */
+		connection_t state();
+
+		/**
+		 * @brief number of dropped messages, because of a full queue or a lost connection
+		 * 
+		 * @return uint32_t dropped messages
+		 */
+		uint32_t dropped();
+
+		/**
+		 * @brief check if the connection has a destination
+		 * 
+		 * @param address destination address
+		 * @return true if begin() was called with this address
+		 */
+		bool assigned(const SocketAddress& address);
+		bool assigned();
+
+	private:
+
+		NetworkInterface* interface;
+		TCPSocket socket;
+		SocketAddress destination;
+		connection_t status;
+		uint32_t retryTime;
+		uint32_t connectTime;
+		uint16_t backoff;
+		char queue[TCP_QUEUE_SIZE];
+		uint16_t queued;
+		uint16_t sent;
+		uint32_t drops;
+		Mutex mutex; // the connection is shared by the loop and the network thread
+		void flush();
+		void fail();
+
+	};
+
+
+/**
+ * @brief OscQueue object, lock-free single producer / single consumer queue of encoded messages,
+ * a message can be coalesced with the queued one with the same address
+ * 
+ */
+class OscQueue {
+
+	public:
+
+		/**
+		 * @brief Construct a new OscQueue object
+		 * 
+		 */
+		OscQueue();
+
+		/**
+		 * @brief queue a message, producer side
+		 * 
+		 * @param msg unframed message
+		 * @param length length of the message
+		 * @param protocol protocol type of the message
+		 * @param mode KEEP, LATEST drops a queued message with the same address and protocol,
+		 * SUM adds its int32 argument to the new message
+		 * @param targets TARGET_CONSOLE and the bits of the destinations
+		 * @return true if the message was queued, false if the queue is full
+		 */
+		bool push(const char* msg, uint16_t length, protocol_t protocol, coalesce_t mode = KEEP, uint8_t targets = TARGET_ALL);
+
+		/**
+		 * @brief oldest queued message, consumer side, stays valid until pop()
+		 * 
+		 * @param length length of the message
+		 * @param protocol protocol type of the message
+		 * @param targets targets of the message
+		 * @return const char* message, nullptr if the queue is empty
+		 */
+		const char* front(uint16_t& length, protocol_t& protocol, uint8_t& targets);
+
+		/**
+		 * @brief remove the message of front(), consumer side
+		 * 
+		 */
+		void pop();
+
+		/**
+		 * @brief number of queued messages
+		 * 
+		 */
+		uint16_t count();
+
+		/**
+		 * @brief number of messages dropped by a full queue
+		 * 
+		 */
+		uint32_t dropped();
+
+		/**
+		 * @brief number of messages coalesced with a newer one
+		 * 
+		 */
+		uint32_t replaced();
+
+	private:
+
+		struct Slot {
+			volatile uint8_t state;
+			uint8_t protocol;
+			uint8_t mode;
+			uint8_t targets;
+			uint16_t length;
+			uint16_t address; // length of the address
+			uint32_t hash; // hash of the address
+			char data[OSC_MESSAGE_SIZE];
+			};
+		Slot slots[QUEUE_SLOTS];
+		volatile uint32_t head; // written by the producer
+		volatile uint32_t tail; // written by the consumer
+		uint32_t drops;
+		uint32_t replaces;
+
+	};
+
+
+/**
+ * @brief counters of a control
+ * 
+ */
+struct ControlStats {
+	uint32_t samples; // updates
+	uint32_t sends; // sent messages
+	uint32_t suppressed; // samples without a message, e.g. jitter or bouncing
+	uint32_t failures; // messages which couldn't be sent or queued
+	uint32_t latency[STATS_BUCKETS]; // time from the input to the send, bucket n counts below 2^n us
+	};
+
+#if GMA3_PROFILE
+/**
+ * @brief Profile object, distribution of a duration in fixed memory
+ * 
+ */
+class Profile {
+
+	public:
+
+		/**
+		 * @brief Construct a new Profile object
+		 * 
+		 */
+		Profile();
+
+		/**
+		 * @brief add a duration
+		 * 
+		 * @param cycles duration in halCycles()
+		 */
+		void add(uint32_t cycles);
+
+		/**
+		 * @brief clear all durations
+		 * 
+		 */
+		void reset();
+
+		/**
+		 * @brief number of durations
+		 * 
+		 * @return uint32_t count
+		 */
+		uint32_t count();
+
+		uint32_t min();
+		uint32_t mean();
+		uint32_t max();
+
+		/**
+		 * @brief percentile of the durations, the upper bound of the histogram bucket, within 25%
+		 * 
+		 * @param percent 1...100
+		 * @return uint32_t duration in cycles
+		 */
+		uint32_t percentile(uint8_t percent);
+
+	private:
+
+		uint32_t samples;
+		uint32_t minimum;
+		uint32_t maximum;
+		uint64_t total;
+		uint16_t histogram[PROFILE_BUCKETS];
+
+	};
+#endif
+
+/**
+ * @brief Control object, base of all hardware elements, registers itself for updateControls()
+ * 
+ */
+class Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new Control object
+		 * 
+		 * @param period poll period in ms
+		 */
+		Control(uint16_t period);
+		virtual ~Control();
+
+		/**
+		 * @brief update the state of the control, must in loop() when updateControls() isn't used
+		 * 
+		 */
+		virtual void update() = 0;
+
+		/**
+		 * @brief set the poll period for updateControls()
+		 * 
+		 * @param period poll period in ms
+		 */
+		void rate(uint16_t period);
+
+		/**
+		 * @brief counters of the control
+		 * 
+		 * @return const ControlStats& counters
+		 */
+		const ControlStats& stats();
+
+		/**
+		 * @brief clear the counters
+		 * 
+		 */
+		void resetStats();
+
+		/**
+		 * @brief name of the control for the diagnostics, e.g. the OSC address
+		 * 
+		 * @param buffer destination buffer
+		 * @param size size of the buffer
+		 */
+		virtual void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief targets of the messages, standard TARGET_ALL
+		 * 
+		 * @param targets TARGET_CONSOLE and the bits of the destinations, e.g. TARGET_CONSOLE | (1 << (backup + 1))
+		 */
+		void route(uint8_t targets);
+
+	protected:
+
+		uint8_t targets; // set by route()
+		ControlStats counters;
+#if GMA3_PROFILE
+		Profile profile; // cost of update()
+#endif
+
+		/**
+		 * @brief called by updateControls() when the control is due, calls update() by default
+		 * 
+		 */
+		virtual void tick();
+
+		/**
+		 * @brief count a message
+		 * 
+		 * @param sent result of the send
+		 * @param start time of the input in us
+		 */
+		void record(bool sent, uint32_t start);
+
+		/**
+		 * @brief send an unframed message to the targets of the control
+		 * 
+		 * @param mode coalescing with a pending message with the same address, KEEP, LATEST or SUM
+		 * @return true if the message was sent or queued
+		 */
+		bool send(const char* osc, uint16_t length, protocol_t protocol, coalesce_t mode = KEEP);
+
+	private:
+
+		uint32_t due;
+		uint32_t period;
+		Control* next;
+		Control* nextControl; // list of all controls
+		bool scheduled;
+		friend void reportControls(uint8_t ip[], uint16_t port);
+#if GMA3_PROFILE
+		friend void profileSend();
+#endif
+		friend void updateControls();
+		friend void scheduleControl(Control* control, uint32_t due);
+		friend void unscheduleControl(Control* control);
+
+	};
+
+
+/**
+ * @brief Debouncer object, takes the first edge of a button from an interrupt with its timestamp
+ * and ignores the bouncing for a lockout time
+ * 
+ */
+class Debouncer {
+
+	public:
+
+		/**
+		 * @brief Construct a new Debouncer object
+		 * 
+		 * @param pin button pin, with pull up
+		 * @param lockout lockout time in ms
+		 */
+		Debouncer(PinName pin, uint16_t lockout = DEBOUNCE_LOCKOUT_MS);
+
+		/**
+		 * @brief set the lockout time
+		 * 
+		 * @param lockout lockout time in ms
+		 */
+		void lockout(uint16_t lockout);
+
+		/**
+		 * @brief next clean edge
+		 * 
+		 * @param level new level of the pin, false is pressed
+		 * @param time timestamp of the edge in us
+		 * @return true if there was an edge
+		 */
+		bool event(bool& level, uint32_t& time);
+
+		/**
+		 * @brief debounced level of the pin
+		 * 
+		 */
+		bool read();
+
+		/**
+		 * @brief number of ignored edges since the last call
+		 * 
+		 */
+		uint32_t bounces();
+
+	private:
+
+		struct Edge {
+			bool level;
+			uint32_t time;
+			};
+		InterruptIn mypin;
+		volatile bool level;
+		volatile bool bounced;
+		volatile uint32_t edgeTime;
+		volatile uint32_t bounceTime;
+		volatile int32_t bounceCount;
+		uint32_t lockoutTime;
+		Edge edges[DEBOUNCE_EVENTS];
+		volatile uint32_t head; // written by the interrupt
+		volatile uint32_t tail;
+		void edgeISR();
+		void push(bool level, uint32_t time);
+
+	};
+
+
+/**
+ * @brief Key object
+ * 
+ */
+class Key : public Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new Key object
+		 * 
+		 * @param pin button pin
+		 * @param page number of the page
+		 * @param key number of the executor button
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		Key(PinName pin, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+
+		/**
+		 * @brief update the state of the Key button, must in loop()
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief name of the control for the diagnostics
+		 * 
+		 */
+		void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief set the debounce lockout time
+		 * 
+		 * @param lockout lockout time in ms, standard DEBOUNCE_LOCKOUT_MS
+		 */
+		void debounce(uint16_t lockout);
+
+		/**
+		 * @brief timestamp of the last press or release
+		 * 
+		 * @return uint32_t time of the edge in us
+		 */
+		uint32_t timestamp();
+
+	private:
+
+		Debouncer mypin;
+		protocol_t protocol;
+		uint16_t page;
+		uint16_t key;
+		uint32_t edgeTime;
+		OscPacket packet;
+		OscPacket* active; // packet of the selected page of a PageBank
+		OscPacket* held; // packet of the press, the release goes to the same page
+		uint32_t generation;
+		friend class PageBank;
+
+	};
+
+
+/**
+ * @brief KeyMatrix object, scans many keys in the background from a ticker, either a direct
+ * row / column matrix or a chain of parallel in shift registers (74HC165)
+ * 
+ */
+class KeyMatrix : public Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new KeyMatrix object for a direct matrix, rows are driven low,
+		 * columns have pull ups, a diode per key is recommanded
+		 * 
+		 * @param rows array of the row pins
+		 * @param rowCount number of rows, maximum KEY_MATRIX_ROWS, 0 gives a matrix without keys
+		 * @param columns array of the column pins
+		 * @param columnCount number of columns, maximum KEY_MATRIX_COLUMNS, 0 gives a matrix without keys
+		 * @param page number of the page
+		 * @param key number of the first executor button, the keys are numbered row by row
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		KeyMatrix(const PinName rows[], uint8_t rowCount, const PinName columns[], uint8_t columnCount, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+
+		/**
+		 * @brief Construct a new KeyMatrix object for a shift register chain, the inputs need pull ups
+		 * 
+		 * @param load parallel load pin (SH/LD)
+		 * @param clock clock pin (CLK)
+		 * @param data serial data pin (QH of the last register)
+		 * @param count number of keys, maximum KEY_MATRIX_KEYS
+		 * @param page number of the page
+		 * @param key number of the first executor button
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		KeyMatrix(PinName load, PinName clock, PinName data, uint16_t count, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+
+		/**
+		 * @brief start the background scan, must in main(), a matrix without keys isn't scanned
+		 * 
+		 * @param period scan period in us
+		 */
+		void begin(uint32_t period = KEY_MATRIX_PERIOD_US);
+
+		/**
+		 * @brief stop the background scan
+		 * 
+		 */
+		void end();
+
+		/**
+		 * @brief use own executor numbers instead of consecutive numbers
+		 * 
+		 * @param keys array of executor numbers, one for each key
+		 */
+		void map(const uint16_t keys[]);
+
+		/**
+		 * @brief send the changed keys, must in loop()
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief name of the control for the diagnostics
+		 * 
+		 */
+		void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief debounced state of a key
+		 * 
+		 * @param index index of the key in the matrix
+		 * @return true if pressed
+		 */
+		bool pressed(uint16_t index);
+
+		/**
+		 * @brief number of keys
+		 * 
+		 */
+		uint16_t count();
+
+		/**
+		 * @brief scan the matrix, called by the ticker
+		 * 
+		 */
+		void scan();
+
+	private:
+
+		static const uint8_t WORDS = (KEY_MATRIX_KEYS + 31) / 32;
+		gpio_t rowPins[KEY_MATRIX_ROWS];
+		gpio_t columnPins[KEY_MATRIX_COLUMNS];
+		gpio_t loadPin;
+		gpio_t clockPin;
+		gpio_t dataPin;
+		bool shift;
+		uint8_t rowCount;
+		uint8_t columnCount;
+		uint8_t row; // driven row of a direct matrix
+		uint16_t keys;
+		const uint16_t* keyMap;
+		uint32_t sample[WORDS]; // scan in progress
+		uint32_t last[WORDS]; // previous scan
+		volatile uint32_t state[WORDS]; // debounced, written by the ticker
+		volatile uint32_t scanTime; // time of the last complete scan
+		uint32_t reported[WORDS]; // state sent to the console
+		Ticker ticker;
+		protocol_t protocol;
+		uint16_t page;
+		uint16_t key;
+		void debounce();
+
+	};
+
+
+/**
+ * @brief FaderBank object, scans all fader channels in the background from a ticker
+ * and publishes the latest samples into a lock-free double buffer,
+ * the scan converts in the ticker interrupt, so standalone Faders and MotorFaders
+ * with their own pin must not use the same ADC, MotorFaders of the bank are fine
+ * 
+ */
+class FaderBank {
+
+	public:
+
+		/**
+		 * @brief Construct a new FaderBank object
+		 * 
+		 * @param pins array of analog pins
+		 * @param count number of pins, maximum FADER_BANK_CHANNELS
+		 */
+		FaderBank(const PinName pins[], uint8_t count);
+
+		/**
+		 * @brief start the background scan, must in main()
+		 * 
+		 * @param period scan period in us
+		 */
+		void begin(uint32_t period = FADER_BANK_PERIOD_US);
+
+		/**
+		 * @brief stop the background scan
+		 * 
+		 */
+		void end();
+
+		/**
+		 * @brief latest sample of a channel, never waits for a conversion
+		 * 
+		 * @param channel number of the channel
+		 * @return uint16_t 16 bit sample
+		 */
+		uint16_t read(uint8_t channel);
+
+		/**
+		 * @brief copy the samples of all channels from the same scan
+		 * 
+		 * @param samples destination with space for all channels
+		 */
+		void snapshot(uint16_t samples[]);
+
+		/**
+		 * @brief scan all channels once, called by the ticker
+		 * 
+		 */
+		void scan();
+
+		/**
+		 * @brief number of channels
+		 * 
+		 * @return uint8_t channels
+		 */
+		uint8_t channels();
+
+		/**
+		 * @brief number of finished scans
+		 * 
+		 * @return uint32_t scans
+		 */
+		uint32_t scans();
+
+	private:
+
+		analogin_t adc[FADER_BANK_CHANNELS];
+		uint8_t count;
+		uint16_t samples[2][FADER_BANK_CHANNELS];
+		volatile uint32_t sequence; // the buffer sequence & 1 is published
+		Ticker ticker;
+
+	};
+
+
+/**
+ * @brief FaderFilter object, base of the filters for the sample chain of a fader
+ * 
+ */
+class FaderFilter {
+
+	public:
+
+		/**
+		 * @brief filter a sample
+		 * 
+		 * @param sample 16 bit sample
+		 * @return uint16_t filtered 16 bit sample
+		 */
+		virtual uint16_t filter(uint16_t sample) = 0;
+
+	private:
+
+		FaderFilter* next = nullptr;
+		friend class Fader;
+
+	};
+
+/**
+ * @brief EmaFilter object, exponential moving average
+ * 
+ */
+class EmaFilter : public FaderFilter {
+
+	public:
+
+		/**
+		 * @brief Construct a new EmaFilter object
+		 * 
+		 * @param shift smoothing, the weight of a new sample is 1 / 2^shift
+		 */
+		EmaFilter(uint8_t shift = 2);
+		uint16_t filter(uint16_t sample);
+
+	private:
+
+		uint8_t shift;
+		uint32_t average; // fixed point with shift fractional bits
+		bool started;
+
+	};
+
+/**
+ * @brief AverageFilter object, moving average of the last samples
+ * 
+ */
+class AverageFilter : public FaderFilter {
+
+	public:
+
+		/**
+		 * @brief Construct a new AverageFilter object
+		 * 
+		 * @param length number of samples, maximum FADER_AVERAGE_SIZE
+		 */
+		AverageFilter(uint8_t length = 4);
+		uint16_t filter(uint16_t sample);
+
+	private:
+
+		uint16_t samples[FADER_AVERAGE_SIZE];
+		uint32_t sum;
+		uint8_t length;
+		uint8_t index;
+		uint8_t filled;
+
+	};
+
+
+/**
+ * @brief Fader object
+ * 
+ */
+class Fader : public Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new Fader object
+		 * 
+		 * @param pin fader leveler pin
+		 * @param page number of the page
+		 * @param key number of the executor button
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		Fader(PinName pin, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+
+		/**
+		 * @brief Construct a new Fader object which gets the samples from a FaderBank
+		 * 
+		 * @param bank FaderBank which scans the fader
+		 * @param channel channel of the FaderBank
+		 * @param page number of the page
+		 * @param key number of the executor button
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		Fader(FaderBank& bank, uint8_t channel, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+
+		/**
+		 * @brief update the state of the Key button, must in loop()
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief name of the control for the diagnostics
+		 * 
+		 */
+		void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief average several conversions for each sample, not used with a FaderBank
+		 * 
+		 * @param count number of conversions
+		 */
+		void oversample(uint8_t count);
+
+		/**
+		 * @brief append a filter to the sample chain, a filter object can only be used once
+		 * 
+		 * @param filter e.g. EmaFilter or AverageFilter
+		 */
+		void filter(FaderFilter& filter);
+
+		/**
+		 * @brief adaptive hysteresis, the narrow threshold is used while the fader moves,
+		 * the wide one after it rests for FADER_SETTLE_MS
+		 * 
+		 * @param moving threshold while moving in 10 bit steps
+		 * @param resting threshold while resting in 10 bit steps
+		 */
+		void hysteresis(uint8_t moving, uint8_t resting);
+
+		/**
+		 * @brief type of the sent value, INT32 0...100 (standard) or FLOAT32 0.0...100.0 with sub-percent resolution
+		 * 
+		 * @param type INT32 or FLOAT32
+		 */
+		void output(osc_t type);
+
+		/**
+		 * @brief send the position with the next update, even if the fader doesn't move
+		 * 
+		 */
+		virtual void resend();
+
+	protected:
+
+		bool forced;
+
+		/**
+		 * @brief raw sample of the fader, from the FaderBank or the oversampled ADC
+		 * 
+		 * @return uint16_t 16 bit sample
+		 */
+		virtual uint16_t read();
+
+		/**
+		 * @brief the position is tracked without sending, e.g. while a motor moves the fader
+		 * 
+		 * @return true to suppress the messages
+		 */
+		virtual bool muted();
+
+	private:
+
+		analogin_t adc;
+		FaderBank* bank;
+		uint8_t channel;
+		protocol_t protocol;
+		uint16_t page;
+		uint16_t key;
+		int32_t analogLast;
+		int32_t valueLast;
+		uint32_t updateTime;
+		FaderFilter* filters;
+		uint8_t oversampling;
+		uint16_t thresholdMoving;
+		uint16_t thresholdResting;
+		uint32_t moveTime;
+		osc_t type;
+		OscPacket packet;
+		OscPacket* active; // packet of the selected page of a PageBank
+		uint32_t generation;
+		void tick();
+		void sample();
+		friend class PageBank;
+		friend class MotorFader;
+
+	};
+
+
+/**
+ * @brief MotorFader object, a Fader with a motor which follows the values of the console,
+ * the position is controlled by a PID loop from a ticker at a fixed rate
+ * 
+ */
+class MotorFader : public Fader {
+
+	public:
+
+		/**
+		 * @brief Construct a new MotorFader object
+		 * 
+		 * @param pin fader leveler pin
+		 * @param pwm PWM pin of the motor driver
+		 * @param direction direction pin of the motor driver, 1 moves up
+		 * @param touch pin of the touch sensor, active high, NC without a sensor
+		 * @param page number of the page
+		 * @param key number of the executor button
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		MotorFader(PinName pin, PinName pwm, PinName direction, PinName touch, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+
+		/**
+		 * @brief Construct a new MotorFader object which gets the samples from a FaderBank
+		 * 
+		 * @param bank FaderBank which scans the fader
+		 * @param channel channel of the FaderBank
+		 * @param pwm PWM pin of the motor driver
+		 * @param direction direction pin of the motor driver, 1 moves up
+		 * @param touch pin of the touch sensor, active high, NC without a sensor
+		 * @param page number of the page
+		 * @param key number of the executor button
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		MotorFader(FaderBank& bank, uint8_t channel, PinName pwm, PinName direction, PinName touch, uint16_t page, uint16_t key, protocol_t protocol = UDP);
+		~MotorFader();
+
+		/**
+		 * @brief start the control loop
+		 * 
+		 * @param period loop period in us
+		 */
+		void begin(uint32_t period = MOTOR_FADER_PERIOD_US);
+
+		/**
+		 * @brief stop the control loop and the motor
+		 * 
+		 */
+		void end();
+
+		/**
+		 * @brief gains of the PID controller, the error and the output are scaled to 0.0...1.0
+		 * 
+		 * @param kp proportional gain
+		 * @param ki integral gain per loop
+		 * @param kd derivative gain per loop
+		 */
+		void pid(float kp, float ki, float kd);
+
+		/**
+		 * @brief move the fader to a value, ignored while the fader is touched
+		 * 
+		 * @param value 0.0...100.0
+		 */
+		void move(float value);
+
+		/**
+		 * @brief handler for oscHandler(), moves the fader to the received value if the address
+		 * is the one of the selected page
+		 * 
+		 * @param msg received message with an int or float value 0...100
+		 * @param context the MotorFader
+		 */
+		static void feedback(OscReader& msg, void* context);
+
+		/**
+		 * @brief the motor moves to a target
+		 * 
+		 * @return true while moving
+		 */
+		bool moving();
+
+		/**
+		 * @brief the knob is touched
+		 * 
+		 * @return true if touched, always false without a sensor
+		 */
+		bool touched();
+
+		/**
+		 * @brief a motor fader doesn't resend on a page switch, it follows the value of the console
+		 * 
+		 */
+		void resend();
+
+	private:
+
+		Ticker ticker;
+		pwmout_t motor;
+		gpio_t directionPin;
+		gpio_t touchPin;
+		bool touchSensor;
+		bool running;
+		volatile int32_t target;
+		volatile uint16_t position;
+		volatile uint8_t driving;
+		volatile uint32_t stopTime;
+		uint32_t driveTicks;
+		uint32_t timeoutTicks;
+		float kp;
+		float ki;
+		float kd;
+		float integral;
+		float errorLast;
+		void init(PinName pwm, PinName direction, PinName touch);
+		void control();
+		void drive(float output);
+		uint16_t read();
+		bool muted();
+
+	};
+
+
+/**
+ * @brief ExecutorKnob object
+ * 
+ */
+class ExecutorKnob : public Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new ExecutorKnob object
+		 * 
+		 * @param pinA pin A of the encoder
+		 * @param pinB pin B of the encoder
+		 * @param page number of the page
+	 	 * @param executorKnob number of the executorKnob
+		 * @param direction the direction for the encoder, can be FORWARD or REVERSE, depends on hardware alignment
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		ExecutorKnob(PinName pinA, PinName pinB, uint16_t page, uint16_t executorKnob, uint8_t direction = FORWARD, protocol_t protocol = UDP);
+
+		/**
+		 * @brief update the output of the executorKnob, must be in loop(),
+		 * the steps are counted by interrupts and the sum since the last update is sent
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief name of the control for the diagnostics
+		 * 
+		 */
+		void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief collect the detents for a time window and send them as one summed value,
+		 * the first detent after a pause is sent immediately
+		 * 
+		 * @param window time in ms, 0 sends with every update (standard)
+		 */
+		void coalesce(uint16_t window);
+
+		/**
+		 * @brief velocity based acceleration, the value is multiplied by 1 + speed * factor / ENCODER_ACCELERATION
+		 * 
+		 * @param factor 0 is off (standard), higher values accelerate faster
+		 */
+		void acceleration(uint8_t factor);
+	
+	private:
+
+		InterruptIn mypinA;
+		InterruptIn mypinB;
+		protocol_t protocol;
+		uint16_t page;
+		uint16_t executorKnob;
+		uint8_t direction;
+		uint8_t encoderState;
+		volatile int32_t encoderCount;
+		uint16_t window;
+		uint8_t accelerationFactor;
+		uint32_t sendTime;
+		OscPacket packet;
+		OscPacket* active; // packet of the selected page of a PageBank
+		uint32_t generation;
+		void encoderISR();
+		friend class PageBank;
+
+	};
+
+
+/**
+ * @brief CndButton object
+ * 
+ */
+class CmdButton : public Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new CmdButton object
+		 * 
+		 * @param pin button pin
+		 * @param command string to command line
+		 * @param protocol type of the used protocol, UDP or TCP
+		 */
+		CmdButton(PinName pin, string command, protocol_t protocol = UDP);
+
+		/**
+		 * @brief update the state of the Key button, must in loop()
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief name of the control for the diagnostics
+		 * 
+		 */
+		void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief set the debounce lockout time
+		 * 
+		 * @param lockout lockout time in ms, standard DEBOUNCE_LOCKOUT_MS
+		 */
+		void debounce(uint16_t lockout);
+
+		/**
+		 * @brief timestamp of the last press or release
+		 * 
+		 * @return uint32_t time of the edge in us
+		 */
+		uint32_t timestamp();
+
+	private:
+
+		Debouncer mypin;
+		protocol_t protocol;
+		string command;
+		uint32_t edgeTime;
+
+	};
+
+
+/**
+ * @brief osc button object, its address is an entry of the destination table shared by the buttons
+ * with the same address and protocol, so queue, coalescing and route() apply like to the other controls,
+ * route() adds further targets, e.g. TARGET_CONSOLE
+ * 
+ */
+class OscButton : public Control {
+
+	public:
+
+		/**
+		 * @brief Construct a new Key object
+		 * 
+		 * @param pin button pin
+		 * @param pattern OSC address
+		 * @param integer32 optional integer value, must cast (int32_t) when using with a non matching size
+		 * @param float32 optional float value
+		 * @param msg optional string message
+		 * @param flag optiona flag
+		 * @param ip destination IP address
+		 * @param externPort destination port
+		 */
+		OscButton(PinName pin, string pattern, int32_t integer32, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
+		OscButton(PinName pin, string pattern, float float32, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
+		OscButton(PinName pin, string pattern, string msg, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
+		OscButton(PinName pin, string pattern, flag_t flag, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
+		OscButton(PinName pin, string pattern, uint8_t ip[], uint16_t port, protocol_t protocol = UDP);
+		~OscButton();
+
+		/**
+		 * @brief update the state of the Key button, must in loop()
+		 * 
+		 */
+		void update();
+
+		/**
+		 * @brief name of the control for the diagnostics
+		 * 
+		 */
+		void label(char* buffer, uint16_t size);
+
+		/**
+		 * @brief set the debounce lockout time
+		 * 
+		 * @param lockout lockout time in ms, standard DEBOUNCE_LOCKOUT_MS
+		 */
+		void debounce(uint16_t lockout);
+
+		/**
+		 * @brief timestamp of the last press or release
+		 * 
+		 * @return uint32_t time of the edge in us
+		 */
+		uint32_t timestamp();
+
+	private:
+
+		SocketAddress address;
+		int8_t entry; // index in the destination table, -1 before the first message
+		Debouncer mypin;
+		protocol_t protocol;
+		string pattern;
+		string msg;
+		int32_t integer32;
+		float float32;
+		flag_t flag;
+		osc_t type;
+		uint32_t edgeTime;
+
+	};
+
+
+/**
+ * @brief PageBank object, switches Faders, Keys and ExecutorKnobs to another executor page,
+ * the messages of all pages are rendered in advance, so a switch only swaps one pointer per control,
+ * the packets take PAGE_BANK_PACKETS * OSC_PACKET_SIZE bytes (about 4.6 KB) per bank,
+ * the destructor returns the controls to their own page
+ * 
+ */
+class PageBank {
+
+	public:
+
+		/**
+		 * @brief Construct a new PageBank object
+		 * 
+		 * @param first number of the first page
+		 * @param count number of pages, first...first + count - 1
+		 */
+		PageBank(uint16_t first, uint8_t count);
+		~PageBank();
+
+		/**
+		 * @brief add a control, it's switched to the selected page
+		 * 
+		 * @param fader, key or executorKnob control
+		 * @return true if there was space in the table
+		 */
+		bool add(Fader& fader);
+		bool add(Key& key);
+		bool add(ExecutorKnob& executorKnob);
+
+		/**
+		 * @brief switch all controls to a page, the Faders send their position on the new page
+		 * 
+		 * @param page number of the page
+		 * @return true if the page is in the bank
+		 */
+		bool select(uint16_t page);
+
+		/**
+		 * @brief the selected page
+		 * 
+		 * @return uint16_t number of the page
+		 */
+		uint16_t selected();
+
+	private:
+
+		struct Member {
+			OscPacket** active;
+			uint16_t* page;
+			const string* name;
+			uint16_t number;
+			uint16_t base; // page of the control before it was added
+			Fader* fader; // type tag and resend
+			OscPacket** held; // packet of a held Key
+			OscPacket* packet; // own packet of a Key
+			};
+
+		Member members[PAGE_BANK_CONTROLS];
+		OscPacket packets[PAGE_BANK_PACKETS]; // packets of member m start at m * count
+		uint16_t first;
+		uint8_t count;
+		uint8_t index;
+		uint8_t memberCount;
+		PageBank* nextBank;
+		bool add(const Member& member);
+		void render(uint8_t member);
+		friend void renderPageBanks();
+
+	};
+
+/**
+ * @brief Creates osc messages with different data types
+ * 
+ * @param osc message
+ * @param value integer32, float, string value
+ * @param flag type value
+ */
+void message(string& osc, int32_t value, protocol_t protocol = UDP);
+void message(string& osc, float value, protocol_t protocol = UDP);
+void message(string& osc, string value, protocol_t protocol = UDP);
+void message(string& osc, flag_t flag, protocol_t protocol = UDP);
+void message(string& osc, protocol_t protocol = UDP);
+
+/**
+ * @brief Creates osc messages with different data types into a fixed size buffer, no heap is used
+ * 
+ * @param buffer destination buffer
+ * @param size size of the destination buffer
+ * @param pattern OSC address
+ * @param value integer32, float, string value
+ * @param flag type value
+ * @return uint16_t length of the message, 0 if the buffer is too small
+ */
+uint16_t message(char* buffer, uint16_t size, const char* pattern, int32_t value, protocol_t protocol = UDP);
+uint16_t message(char* buffer, uint16_t size, const char* pattern, float value, protocol_t protocol = UDP);
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const char* value, protocol_t protocol = UDP);
+uint16_t message(char* buffer, uint16_t size, const char* pattern, flag_t flag, protocol_t protocol = UDP);
+uint16_t message(char* buffer, uint16_t size, const char* pattern, protocol_t protocol = UDP);
+
+/**
+ * @brief encode an OSC message with mixed arguments, the type tags are taken from the argument types
+ * 
+ * @param buffer destination buffer
+ * @param size size of the destination buffer
+ * @param protocol type of the used protocol
+ * @param pattern OSC address
+ * @param args arguments, integers ('i' or 'h'), float, double, const char* or OscBlob
+ * @return uint16_t length of the message, 0 if the buffer is too small
+ */
+template <typename... Args>
+uint16_t oscMessage(char* buffer, uint16_t size, protocol_t protocol, const char* pattern, Args... args) {
+	OscWriter osc(buffer, size);
+	osc.message(pattern, args...);
+	osc.frame(protocol);
+	return osc.length();
+	}
+
+/**
+ * @brief encode an OSC message with many arguments of the same type, e.g. ",iiii", or a blob
+ * 
+ * @param buffer destination buffer
+ * @param size size of the destination buffer
+ * @param pattern OSC address
+ * @param values integer32 or float values
+ * @param count number of values
+ * @param data blob data
+ * @param length length of the blob
+ * @return uint16_t length of the message, 0 if the buffer is too small
+ */
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const int32_t values[], uint8_t count, protocol_t protocol = UDP);
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const float values[], uint8_t count, protocol_t protocol = UDP);
+uint16_t message(char* buffer, uint16_t size, const char* pattern, const void* data, uint16_t length, protocol_t protocol = UDP);
+
+/**
+ * @brief Encode messages with SLIP, without a size limit
  * 
  * @param msg message
  */
 void slipEncode(string& msg);
 
 /**
- * @brief Decode SLIP encoded messages
+ * @brief Encode a message buffer in place with SLIP
+ * 
+ * @param msg message buffer
+ * @param length length of the message
+ * @param size size of the buffer
+ * @return uint16_t length of the encoded message, 0 if the buffer is too small
+ */
+uint16_t slipEncode(char* msg, uint16_t length, uint16_t size);
+
+/**
+ * @brief Encode a message with SLIP in a single pass into an output buffer
+ * 
+ * @param msg message buffer
+ * @param length length of the message
+ * @param out output buffer, use slipLength() for the needed size
+ * @param size size of the output buffer
+ * @return uint16_t length of the encoded message, 0 if the output buffer is too small
+ */
+uint16_t slipEncode(const char* msg, uint16_t length, char* out, uint16_t size);
+
+/**
+ * @brief Calculate the length of a SLIP encoded message
+ * 
+ * @param msg message buffer
+ * @param length length of the message
+ * @return uint32_t length of the encoded message including both END bytes
+ */
+uint32_t slipLength(const char* msg, uint16_t length);
+
+/**
+ * @brief Decode SLIP encoded messages in place, without a size limit
  * 
  * @param msg message
  */
 void slipDecode(string& msg);
 
+/**
+ * @brief Decode a SLIP encoded message in a single pass into an output buffer
+ * 
+ * @param msg encoded message buffer
+ * @param length length of the encoded message
+ * @param out output buffer, can be the same as msg
+ * @param size size of the output buffer
+ * @return uint16_t length of the decoded message, 0 if the output buffer is too small
+ */
+uint16_t slipDecode(const char* msg, uint16_t length, char* out, uint16_t size);
+
+/**
+ * @brief SlipDecoder object, decodes a SLIP stream received in arbitrary chunks into complete frames
+ * 
+ */
+class SlipDecoder {
+
+	public:
+
+		/**
+		 * @brief Construct a new SlipDecoder object
+		 * 
+		 * @param buffer frame buffer
+		 * @param size size of the frame buffer, frames which are longer are dropped
+		 */
+		SlipDecoder(char* buffer, uint16_t size);
+
+		/**
+		 * @brief decode received bytes, stops after a complete frame
+		 * 
+		 * @param data received bytes
+		 * @param length number of received bytes
+		 * @return uint16_t number of consumed bytes, call again with the rest
+		 */
+		uint16_t decode(const char* data, uint16_t length);
+
+		/**
+		 * @brief check for a complete frame, valid until the next decode()
+		 * 
+		 * @return true if a frame is available
+		 */
+		bool available();
+
+		/**
+		 * @brief the decoded frame
+		 * 
+		 * @return const char* frame data
+		 */
+		const char* data();
+
+		/**
+		 * @brief length of the decoded frame
+		 * 
+		 * @return uint16_t length
+		 */
+		uint16_t length();
+
+		/**
+		 * @brief number of frames dropped because of the buffer size
+		 * 
+		 * @return uint32_t dropped frames
+		 */
+		uint32_t dropped();
+
+	private:
+
+		char* buffer;
+		uint16_t size;
+		uint16_t position;
+		uint32_t drops;
+		bool escape;
+		bool overflow;
+		bool complete;
+
+	};
+
+/**
+ * @brief TcpDecoder object, decodes a length prefixed stream received in arbitrary chunks into complete frames
+ * 
+ */
+class TcpDecoder {
+
+	public:
+
+		/**
+		 * @brief Construct a new TcpDecoder object
+		 * 
+		 * @param buffer frame buffer
+		 * @param size size of the frame buffer, frames which are longer are dropped
+		 */
+		TcpDecoder(char* buffer, uint16_t size);
+
+		/**
+		 * @brief decode received bytes, stops after a complete frame
+		 * 
+		 * @param data received bytes
+		 * @param length number of received bytes
+		 * @return uint16_t number of consumed bytes, call again with the rest
+		 */
+		uint16_t decode(const char* data, uint16_t length);
+
+		/**
+		 * @brief check for a complete frame, valid until the next decode()
+		 * 
+		 * @return true if a frame is available
+		 */
+		bool available();
+
+		/**
+		 * @brief the decoded frame
+		 * 
+		 * @return const char* frame data
+		 */
+		const char* data();
+
+		/**
+		 * @brief length of the decoded frame
+		 * 
+		 * @return uint16_t length
+		 */
+		uint16_t length();
+
+		/**
+		 * @brief number of frames dropped because of the buffer size
+		 * 
+		 * @return uint32_t dropped frames
+		 */
+		uint32_t dropped();
+
+	private:
+
+		char* buffer;
+		uint16_t size;
+		uint32_t expected;
+		uint32_t position;
+		uint8_t header;
+		uint32_t drops;
+		bool complete;
+
+	};
+
 /**
  * @brief Decode messages with Lengh identifier
  * 
@@ -372,6 +2252,16 @@ void slipDecode(string& msg);
  */
 void tcpEncode(string& msg);
 
+/**
+ * @brief Encode a message buffer in place with Length identifier
+ * 
+ * @param msg message buffer
+ * @param length length of the message
+ * @param size size of the buffer
+ * @return uint16_t length of the encoded message, 0 if the buffer is too small
+ */
+uint16_t tcpEncode(char* msg, uint16_t length, uint16_t size);
+
 /**
  * @brief Encode messages with Lengh identifier
  * 
@@ -0,0 +1,86 @@
+/*
+gma3 OSC library for Mbed Ethernet UDP is placed under the MIT license
+Copyright (c) 2020 Stefan Staub
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef GMA3_HAL_H
+#define GMA3_HAL_H
+
+/*
+The library uses the Mbed API for pins and sockets. On Mbed the real drivers
+are used, on other platforms (or with GMA3_POSIX defined) gma3_posix.h provides
+the same classes with simulated pins and POSIX sockets, so the library can
+run on a Linux host.
+*/
+
+#if defined(__MBED__) && !defined(GMA3_POSIX)
+
+#include "mbed.h"
+#include "EthernetInterface.h"
+
+/**
+ * @brief microsecond clock, wraps around after about 71 minutes
+ * 
+ * @return uint32_t time in us
+ */
+inline uint32_t halMicros() {
+	return us_ticker_read();
+	}
+
+/**
+ * @brief cycle counter for profiling, the DWT counter on Cortex-M3 and above,
+ * the microsecond ticker otherwise
+ * 
+ * @return uint32_t cycles
+ */
+inline uint32_t halCycles() {
+#if defined(DWT) && defined(DWT_CTRL_CYCCNTENA_Msk)
+	if (!(DWT->CTRL & DWT_CTRL_CYCCNTENA_Msk)) {
+		CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+		DWT->CYCCNT = 0;
+		DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+		}
+	return DWT->CYCCNT;
+#else
+	return us_ticker_read();
+#endif
+	}
+
+/**
+ * @brief frequency of halCycles()
+ * 
+ * @return uint32_t cycles per second
+ */
+inline uint32_t halCycleFrequency() {
+#if defined(DWT) && defined(DWT_CTRL_CYCCNTENA_Msk)
+	return SystemCoreClock;
+#else
+	return 1000000;
+#endif
+	}
+
+#else
+
+#include "gma3_posix.h"
+
+#endif
+
+#endif
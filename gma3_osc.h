@@ -0,0 +1,279 @@
+/*
+gma3 OSC library for Mbed Ethernet UDP is placed under the MIT license
+Copyright (c) 2020 Stefan Staub
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef GMA3_OSC_H
+#define GMA3_OSC_H
+
+/*
+OSC messages with an address known at compile time. The padded address and
+the type tags are built by the compiler from the argument types, so sending
+is a copy of the constant header plus the big endian arguments.
+
+constexpr auto key201 = oscTemplate<int32_t>("/Page1/Key201");
+char osc[key201.size()];
+sendUDP(osc, key201.message(osc, sizeof(osc), BUTTON_PRESS));
+*/
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <type_traits>
+
+/**
+ * @brief size of an OSC string with the terminating 1 to 4 zeros
+ * 
+ * @param length length of the string
+ * @return size_t padded size, a multiple of 4
+ */
+constexpr size_t oscPadded(size_t length) {
+	return (length / 4 + 1) * 4;
+	}
+
+/**
+ * @brief store a 32 bit value big endian, a single byte swap and word store on little endian targets
+ * 
+ * @param buffer destination, needs no alignment
+ * @param value value
+ */
+inline void oscStore32(char* buffer, uint32_t value) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	value = __builtin_bswap32(value); // REV on ARM
+	memcpy(buffer, &value, 4);
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	memcpy(buffer, &value, 4);
+#else
+	buffer[0] = value >> 24;
+	buffer[1] = value >> 16;
+	buffer[2] = value >> 8;
+	buffer[3] = value;
+#endif
+	}
+
+/**
+ * @brief load a big endian 32 bit value
+ * 
+ * @param buffer source, needs no alignment
+ * @return uint32_t value
+ */
+inline uint32_t oscLoad32(const char* buffer) {
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+	uint32_t value;
+	memcpy(&value, buffer, 4);
+	return __builtin_bswap32(value);
+#elif defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+	uint32_t value;
+	memcpy(&value, buffer, 4);
+	return value;
+#else
+	return ((uint32_t)(uint8_t)buffer[0] << 24) | ((uint32_t)(uint8_t)buffer[1] << 16) | ((uint32_t)(uint8_t)buffer[2] << 8) | (uint8_t)buffer[3];
+#endif
+	}
+
+/**
+ * @brief blob argument, type tag 'b'
+ * 
+ */
+struct OscBlob {
+	const void* data;
+	uint16_t length;
+	};
+
+/**
+ * @brief OSC type tag of an argument type, with the encoded type and its size,
+ * integers up to 32 bit are sent as 'i', 64 bit integers as 'h'
+ * 
+ */
+template <typename T, typename Enable = void>
+struct OscTag;
+
+template <typename T>
+struct OscTag<T, typename std::enable_if<std::is_integral<T>::value && (sizeof(T) <= 4)>::type> {
+	typedef int32_t type;
+	static constexpr char tag = 'i';
+	static constexpr size_t size = 4;
+	};
+
+template <typename T>
+struct OscTag<T, typename std::enable_if<std::is_integral<T>::value && (sizeof(T) == 8)>::type> {
+	typedef int64_t type;
+	static constexpr char tag = 'h';
+	static constexpr size_t size = 8;
+	};
+
+template <>
+struct OscTag<float> {
+	typedef float type;
+	static constexpr char tag = 'f';
+	static constexpr size_t size = 4;
+	};
+
+template <>
+struct OscTag<double> {
+	typedef double type;
+	static constexpr char tag = 'd';
+	static constexpr size_t size = 8;
+	};
+
+template <>
+struct OscTag<const char*> {
+	typedef const char* type;
+	static constexpr char tag = 's';
+	};
+
+template <>
+struct OscTag<char*> : OscTag<const char*> {};
+
+template <>
+struct OscTag<OscBlob> {
+	typedef OscBlob type;
+	static constexpr char tag = 'b';
+	};
+
+/**
+ * @brief sum of the argument sizes, only for fixed size types
+ * 
+ */
+template <typename... Types>
+constexpr size_t oscSize() {
+	const size_t sizes[] = {0, OscTag<Types>::size...};
+	size_t sum = 0;
+	for (size_t i = 0; i < sizeof...(Types) + 1; i++) {
+		sum += sizes[i];
+		}
+	return sum;
+	}
+
+/**
+ * @brief OscTemplate object, a message header built at compile time
+ * 
+ * @tparam A size of the address literal
+ * @tparam Types types of the arguments, integers, float or double
+ */
+template <size_t A, typename... Types>
+class OscTemplate {
+
+	public:
+
+		/**
+		 * @brief Construct a new OscTemplate object, use oscTemplate() instead
+		 * 
+		 * @param address OSC address
+		 */
+		constexpr OscTemplate(const char (&address)[A]) : header{} {
+			const char tags[] = {OscTag<Types>::tag..., '\0'};
+			for (size_t i = 0; i < A - 1; i++) {
+				header[i] = address[i];
+				}
+			header[oscPadded(A - 1)] = ',';
+			for (size_t i = 0; i < sizeof...(Types); i++) {
+				header[oscPadded(A - 1) + 1 + i] = tags[i];
+				}
+			}
+
+		/**
+		 * @brief encode a message with the constant header
+		 * 
+		 * @param buffer destination buffer
+		 * @param size size of the buffer
+		 * @param args the arguments
+		 * @return uint16_t length of the message, 0 if the buffer is too small
+		 */
+		uint16_t message(char* buffer, uint16_t size, Types... args) const {
+			if (size < this->size()) return 0;
+			memcpy(buffer, header, sizeof(header));
+			char* argument = buffer + sizeof(header);
+			int expand[] = {0, (put(argument, (typename OscTag<Types>::type)args), 0)...};
+			(void)expand;
+			(void)argument;
+			return this->size();
+			}
+
+		/**
+		 * @brief the constant header, address and type tags
+		 * 
+		 */
+		constexpr const char* data() const {
+			return header;
+			}
+
+		/**
+		 * @brief length of the header
+		 * 
+		 */
+		constexpr size_t length() const {
+			return sizeof(header);
+			}
+
+		/**
+		 * @brief size of a complete message
+		 * 
+		 */
+		constexpr size_t size() const {
+			return sizeof(header) + oscSize<Types...>();
+			}
+
+	private:
+
+		char header[oscPadded(A - 1) + oscPadded(sizeof...(Types) + 1)];
+
+		static void put(char*& buffer, uint32_t value) {
+			oscStore32(buffer, value);
+			buffer += 4;
+			}
+
+		static void put(char*& buffer, int32_t value) {
+			put(buffer, (uint32_t)value);
+			}
+
+		static void put(char*& buffer, float value) {
+			uint32_t data;
+			memcpy(&data, &value, sizeof(data));
+			put(buffer, data);
+			}
+
+		static void put(char*& buffer, int64_t value) {
+			put(buffer, (uint32_t)((uint64_t)value >> 32));
+			put(buffer, (uint32_t)value);
+			}
+
+		static void put(char*& buffer, double value) {
+			uint64_t data;
+			memcpy(&data, &value, sizeof(data));
+			put(buffer, (int64_t)data);
+			}
+
+	};
+
+/**
+ * @brief build a message header at compile time
+ * 
+ * @tparam Types types of the arguments, integers, float or double
+ * @param address OSC address, a string literal
+ * @return OscTemplate header
+ */
+template <typename... Types, size_t A>
+constexpr OscTemplate<A, Types...> oscTemplate(const char (&address)[A]) {
+	return OscTemplate<A, Types...>(address);
+	}
+
+#endif
@@ -0,0 +1,500 @@
+#if !defined(__MBED__) || defined(GMA3_POSIX)
+
+#include "gma3_posix.h"
+#include <atomic>
+#include <mutex>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+
+std::atomic<int> simDigital[SIM_PINS];
+std::atomic<bool> simDigitalSet[SIM_PINS];
+std::atomic<uint16_t> simAnalog[SIM_PINS];
+std::atomic<float> simPwm[SIM_PINS];
+InterruptIn* simInterrupts[SIM_PINS];
+std::recursive_mutex simInterruptLock; // interrupts of different threads are serialized like on a single core
+
+/**
+ * @brief convert errno of a socket call to a nsapi error
+ * 
+ */
+static nsapi_error_t socketError() {
+	switch (errno) {
+		case EAGAIN:
+			return NSAPI_ERROR_WOULD_BLOCK;
+		case EINPROGRESS:
+			return NSAPI_ERROR_IN_PROGRESS;
+		case EALREADY:
+			return NSAPI_ERROR_ALREADY;
+		case EISCONN:
+			return NSAPI_ERROR_IS_CONNECTED;
+		case ENOTCONN:
+		case ECONNREFUSED:
+			return NSAPI_ERROR_NO_CONNECTION;
+		case ECONNRESET:
+		case EPIPE:
+			return NSAPI_ERROR_CONNECTION_LOST;
+		default:
+			return NSAPI_ERROR_DEVICE_ERROR;
+		}
+	}
+
+static void socketAddress(const SocketAddress& address, sockaddr_in& socket) {
+	memset(&socket, 0, sizeof(socket));
+	socket.sin_family = AF_INET;
+	socket.sin_port = htons(address.get_port());
+	memcpy(&socket.sin_addr, address.get_ip_bytes(), 4);
+	}
+
+uint32_t halMicros() {
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000 + time.tv_nsec / 1000;
+	}
+
+uint32_t halCycles() {
+	timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000 + time.tv_nsec;
+	}
+
+void core_util_critical_section_enter() {
+	simInterruptLock.lock();
+	}
+
+void core_util_critical_section_exit() {
+	simInterruptLock.unlock();
+	}
+
+void simulatePin(PinName pin, int value) {
+	if ((pin < 0) || (pin >= SIM_PINS)) return;
+	std::lock_guard<std::recursive_mutex> lock(simInterruptLock);
+	int last = simDigital[pin].exchange(value ? 1 : 0);
+	simDigitalSet[pin] = true;
+	if (last == (value ? 1 : 0)) return;
+	for (InterruptIn* interrupt = simInterrupts[pin]; interrupt; interrupt = interrupt->next) {
+		if (!interrupt->enabled) continue;
+		if (value && interrupt->riseHandler) interrupt->riseHandler();
+		if (!value && interrupt->fallHandler) interrupt->fallHandler();
+		}
+	}
+
+void simulateAnalog(PinName pin, uint16_t value) {
+	if ((pin < 0) || (pin >= SIM_PINS)) return;
+	simAnalog[pin] = value;
+	}
+
+float simulatedPwm(PinName pin) {
+	if ((pin < 0) || (pin >= SIM_PINS)) return 0.0f;
+	return simPwm[pin];
+	}
+
+DigitalIn::DigitalIn(PinName pin, PinMode mode) {
+	this->pin = pin;
+	// an open input follows the pull resistor
+	if ((pin >= 0) && (pin < SIM_PINS) && !simDigitalSet[pin]) {
+		simDigital[pin] = (mode == PullUp) ? 1 : 0;
+		}
+	}
+
+int DigitalIn::read() {
+	if ((pin < 0) || (pin >= SIM_PINS)) return 0;
+	return simDigital[pin];
+	}
+
+DigitalIn::operator int() {
+	return read();
+	}
+
+InterruptIn::InterruptIn(PinName pin) : InterruptIn(pin, PullDefault) {}
+
+InterruptIn::InterruptIn(PinName pin, PinMode mode) {
+	this->pin = pin;
+	enabled = true;
+	next = nullptr;
+	if ((pin < 0) || (pin >= SIM_PINS)) return;
+	this->mode(mode);
+	std::lock_guard<std::recursive_mutex> lock(simInterruptLock);
+	next = simInterrupts[pin];
+	simInterrupts[pin] = this;
+	}
+
+InterruptIn::~InterruptIn() {
+	if ((pin < 0) || (pin >= SIM_PINS)) return;
+	std::lock_guard<std::recursive_mutex> lock(simInterruptLock);
+	for (InterruptIn** interrupt = &simInterrupts[pin]; *interrupt; interrupt = &(*interrupt)->next) {
+		if (*interrupt == this) {
+			*interrupt = next;
+			break;
+			}
+		}
+	}
+
+int InterruptIn::read() {
+	if ((pin < 0) || (pin >= SIM_PINS)) return 0;
+	return simDigital[pin];
+	}
+
+InterruptIn::operator int() {
+	return read();
+	}
+
+void InterruptIn::mode(PinMode pull) {
+	if ((pin >= 0) && (pin < SIM_PINS) && !simDigitalSet[pin]) {
+		simDigital[pin] = (pull == PullUp) ? 1 : 0;
+		}
+	}
+
+void InterruptIn::rise(Callback<void()> func) {
+	std::lock_guard<std::recursive_mutex> lock(simInterruptLock);
+	riseHandler = func;
+	}
+
+void InterruptIn::fall(Callback<void()> func) {
+	std::lock_guard<std::recursive_mutex> lock(simInterruptLock);
+	fallHandler = func;
+	}
+
+void InterruptIn::enable_irq() {
+	enabled = true;
+	}
+
+void InterruptIn::disable_irq() {
+	enabled = false;
+	}
+
+AnalogIn::AnalogIn(PinName pin) {
+	this->pin = pin;
+	}
+
+uint16_t AnalogIn::read_u16() {
+	if ((pin < 0) || (pin >= SIM_PINS)) return 0;
+	return simAnalog[pin];
+	}
+
+float AnalogIn::read() {
+	return read_u16() / 65535.0f;
+	}
+
+void gpio_init_in_ex(gpio_t* obj, PinName pin, PinMode mode) {
+	obj->pin = pin;
+	if ((pin >= 0) && (pin < SIM_PINS) && !simDigitalSet[pin]) {
+		simDigital[pin] = (mode == PullUp) ? 1 : 0;
+		}
+	}
+
+void gpio_init_out_ex(gpio_t* obj, PinName pin, int value) {
+	obj->pin = pin;
+	gpio_write(obj, value);
+	}
+
+int gpio_read(gpio_t* obj) {
+	if ((obj->pin < 0) || (obj->pin >= SIM_PINS)) return 0;
+	return simDigital[obj->pin];
+	}
+
+void gpio_write(gpio_t* obj, int value) {
+	simulatePin(obj->pin, value);
+	}
+
+void analogin_init(analogin_t* obj, PinName pin) {
+	obj->pin = pin;
+	}
+
+uint16_t analogin_read_u16(analogin_t* obj) {
+	if ((obj->pin < 0) || (obj->pin >= SIM_PINS)) return 0;
+	return simAnalog[obj->pin];
+	}
+
+void pwmout_init(pwmout_t* obj, PinName pin) {
+	obj->pin = pin;
+	pwmout_write(obj, 0.0f);
+	}
+
+void pwmout_free(pwmout_t* obj) {
+	pwmout_write(obj, 0.0f);
+	}
+
+void pwmout_period_us(pwmout_t* obj, int us) {
+	(void)obj;
+	(void)us;
+	}
+
+void pwmout_write(pwmout_t* obj, float percent) {
+	if ((obj->pin < 0) || (obj->pin >= SIM_PINS)) return;
+	if (percent < 0.0f) percent = 0.0f;
+	if (percent > 1.0f) percent = 1.0f;
+	simPwm[obj->pin] = percent;
+	}
+
+float pwmout_read(pwmout_t* obj) {
+	if ((obj->pin < 0) || (obj->pin >= SIM_PINS)) return 0.0f;
+	return simPwm[obj->pin];
+	}
+
+Ticker::Ticker() {
+	running = false;
+	}
+
+Ticker::~Ticker() {
+	detach();
+	}
+
+void Ticker::attach(Callback<void()> func, std::chrono::microseconds period) {
+	detach();
+	running = true;
+	thread = std::thread([this, func, period]() {
+		std::chrono::steady_clock::time_point next = std::chrono::steady_clock::now() + period;
+		while (running) {
+			std::this_thread::sleep_until(next);
+			if (!running) break;
+			{
+				// interrupts are serialized like on a single core
+				std::lock_guard<std::recursive_mutex> lock(simInterruptLock);
+				func();
+			}
+			next += period;
+			}
+		});
+	}
+
+void Ticker::detach() {
+	running = false;
+	if (thread.joinable()) thread.join();
+	}
+
+Thread::Thread(osPriority priority, uint32_t stack_size) {
+	(void)priority;
+	(void)stack_size;
+	}
+
+Thread::~Thread() {
+	if (thread.joinable()) thread.join();
+	}
+
+osStatus Thread::start(Callback<void()> task) {
+	thread = std::thread([task]() { task(); });
+	return osOK;
+	}
+
+osStatus Thread::join() {
+	if (thread.joinable()) thread.join();
+	return osOK;
+	}
+
+void ThisThread::sleep_for(std::chrono::milliseconds duration) {
+	std::this_thread::sleep_for(duration);
+	}
+
+void ThisThread::yield() {
+	std::this_thread::yield();
+	}
+
+Semaphore::Semaphore(int32_t count) {
+	this->count = count;
+	}
+
+osStatus Semaphore::release() {
+	std::lock_guard<std::mutex> guard(lock);
+	count++;
+	signal.notify_one();
+	return osOK;
+	}
+
+void Semaphore::acquire() {
+	std::unique_lock<std::mutex> guard(lock);
+	signal.wait(guard, [this]() { return count > 0; });
+	count--;
+	}
+
+bool Semaphore::try_acquire() {
+	std::lock_guard<std::mutex> guard(lock);
+	if (count == 0) return false;
+	count--;
+	return true;
+	}
+
+bool Semaphore::try_acquire_for(std::chrono::milliseconds timeout) {
+	std::unique_lock<std::mutex> guard(lock);
+	if (!signal.wait_for(guard, timeout, [this]() { return count > 0; })) return false;
+	count--;
+	return true;
+	}
+
+void Mutex::lock() {
+	mutex.lock();
+	}
+
+void Mutex::unlock() {
+	mutex.unlock();
+	}
+
+bool Mutex::trylock() {
+	return mutex.try_lock();
+	}
+
+SocketAddress::SocketAddress() {
+	memset(ip, 0, sizeof(ip));
+	port = 0;
+	}
+
+SocketAddress::SocketAddress(const void* bytes, nsapi_version_t version, uint16_t port) {
+	set_ip_bytes(bytes, version);
+	this->port = port;
+	}
+
+SocketAddress::SocketAddress(const char* address, uint16_t port) {
+	memset(ip, 0, sizeof(ip));
+	inet_pton(AF_INET, address, ip);
+	this->port = port;
+	}
+
+void SocketAddress::set_ip_bytes(const void* bytes, nsapi_version_t version) {
+	(void)version;
+	memcpy(ip, bytes, sizeof(ip));
+	}
+
+void SocketAddress::set_port(uint16_t port) {
+	this->port = port;
+	}
+
+const void* SocketAddress::get_ip_bytes() const {
+	return ip;
+	}
+
+uint16_t SocketAddress::get_port() const {
+	return port;
+	}
+
+bool SocketAddress::operator==(const SocketAddress& address) const {
+	return (memcmp(ip, address.ip, sizeof(ip)) == 0) && (port == address.port);
+	}
+
+bool SocketAddress::operator!=(const SocketAddress& address) const {
+	return !(*this == address);
+	}
+
+nsapi_error_t NetworkInterface::connect() {
+	return NSAPI_ERROR_OK;
+	}
+
+nsapi_error_t NetworkInterface::disconnect() {
+	return NSAPI_ERROR_OK;
+	}
+
+nsapi_error_t EthernetInterface::set_network(const SocketAddress& ip, const SocketAddress& netmask, const SocketAddress& gateway) {
+	(void)ip;
+	(void)netmask;
+	(void)gateway;
+	return NSAPI_ERROR_OK;
+	}
+
+Socket::Socket() {
+	fd = -1;
+	blocking = true;
+	}
+
+Socket::~Socket() {
+	close();
+	}
+
+nsapi_error_t Socket::open(int type) {
+	if (fd >= 0) return NSAPI_ERROR_PARAMETER;
+	fd = socket(AF_INET, type, 0);
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	configure();
+	return NSAPI_ERROR_OK;
+	}
+
+nsapi_error_t Socket::close() {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	::close(fd);
+	fd = -1;
+	return NSAPI_ERROR_OK;
+	}
+
+void Socket::set_blocking(bool blocking) {
+	this->blocking = blocking;
+	configure();
+	}
+
+void Socket::set_timeout(int timeout) {
+	set_blocking(timeout != 0);
+	}
+
+void Socket::configure() {
+	if (fd < 0) return;
+	int flags = fcntl(fd, F_GETFL, 0);
+	fcntl(fd, F_SETFL, blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK));
+	}
+
+nsapi_error_t UDPSocket::open(NetworkInterface* interface) {
+	(void)interface;
+	return Socket::open(SOCK_DGRAM);
+	}
+
+nsapi_error_t UDPSocket::bind(uint16_t port) {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	sockaddr_in local;
+	memset(&local, 0, sizeof(local));
+	local.sin_family = AF_INET;
+	local.sin_port = htons(port);
+	local.sin_addr.s_addr = htonl(INADDR_ANY);
+	if (::bind(fd, (sockaddr*)&local, sizeof(local)) < 0) return socketError();
+	return NSAPI_ERROR_OK;
+	}
+
+nsapi_size_or_error_t UDPSocket::sendto(const SocketAddress& address, const void* data, nsapi_size_t size) {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	sockaddr_in destination;
+	socketAddress(address, destination);
+	ssize_t result = ::sendto(fd, data, size, 0, (sockaddr*)&destination, sizeof(destination));
+	if (result < 0) return socketError();
+	return result;
+	}
+
+nsapi_size_or_error_t UDPSocket::recvfrom(SocketAddress* address, void* data, nsapi_size_t size) {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	sockaddr_in source;
+	socklen_t length = sizeof(source);
+	ssize_t result = ::recvfrom(fd, data, size, 0, (sockaddr*)&source, &length);
+	if (result < 0) return socketError();
+	if (address) {
+		address->set_ip_bytes(&source.sin_addr, NSAPI_IPv4);
+		address->set_port(ntohs(source.sin_port));
+		}
+	return result;
+	}
+
+nsapi_error_t TCPSocket::open(NetworkInterface* interface) {
+	(void)interface;
+	return Socket::open(SOCK_STREAM);
+	}
+
+nsapi_error_t TCPSocket::connect(const SocketAddress& address) {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	sockaddr_in destination;
+	socketAddress(address, destination);
+	if (::connect(fd, (sockaddr*)&destination, sizeof(destination)) < 0) return socketError();
+	return NSAPI_ERROR_OK;
+	}
+
+nsapi_size_or_error_t TCPSocket::send(const void* data, nsapi_size_t size) {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	ssize_t result = ::send(fd, data, size, MSG_NOSIGNAL);
+	if (result < 0) return socketError();
+	return result;
+	}
+
+nsapi_size_or_error_t TCPSocket::recv(void* data, nsapi_size_t size) {
+	if (fd < 0) return NSAPI_ERROR_NO_SOCKET;
+	ssize_t result = ::recv(fd, data, size, 0);
+	if (result < 0) return socketError();
+	return result;
+	}
+
+#endif
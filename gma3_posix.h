@@ -0,0 +1,541 @@
+/*
+gma3 OSC library for Mbed Ethernet UDP is placed under the MIT license
+Copyright (c) 2020 Stefan Staub
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in
+all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+THE SOFTWARE.
+*/
+
+#ifndef GMA3_POSIX_H
+#define GMA3_POSIX_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <functional>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+
+// number of simulated pins
+#define SIM_PINS 128
+
+typedef enum {
+	D0, D1, D2, D3, D4, D5, D6, D7, D8, D9, D10, D11, D12, D13, D14, D15,
+	A0, A1, A2, A3, A4, A5,
+	NC = -1
+	} PinName;
+
+typedef enum {
+	PullNone,
+	PullUp,
+	PullDown,
+	OpenDrain,
+	PullDefault = PullNone
+	} PinMode;
+
+typedef enum {
+	NSAPI_UNSPEC,
+	NSAPI_IPv4,
+	NSAPI_IPv6
+	} nsapi_version_t;
+
+typedef int nsapi_error_t;
+typedef int nsapi_size_or_error_t;
+typedef unsigned int nsapi_size_t;
+
+#define NSAPI_ERROR_OK             0
+#define NSAPI_ERROR_WOULD_BLOCK    -3001
+#define NSAPI_ERROR_UNSUPPORTED    -3002
+#define NSAPI_ERROR_PARAMETER      -3003
+#define NSAPI_ERROR_NO_CONNECTION  -3004
+#define NSAPI_ERROR_NO_SOCKET      -3005
+#define NSAPI_ERROR_DEVICE_ERROR   -3012
+#define NSAPI_ERROR_IN_PROGRESS    -3013
+#define NSAPI_ERROR_ALREADY        -3014
+#define NSAPI_ERROR_IS_CONNECTED   -3015
+#define NSAPI_ERROR_CONNECTION_LOST  -3016
+
+/**
+ * @brief microsecond clock, wraps around after about 71 minutes like the Mbed ticker
+ * 
+ * @return uint32_t time in us
+ */
+uint32_t halMicros();
+
+/**
+ * @brief cycle counter for profiling, nanoseconds of the monotonic clock
+ * 
+ * @return uint32_t time in ns
+ */
+uint32_t halCycles();
+
+/**
+ * @brief frequency of halCycles()
+ * 
+ * @return uint32_t cycles per second
+ */
+inline uint32_t halCycleFrequency() {
+	return 1000000000;
+	}
+
+/**
+ * @brief set the level of a simulated digital pin
+ * 
+ * @param pin pin name
+ * @param value level 0 or 1
+ */
+void simulatePin(PinName pin, int value);
+
+/**
+ * @brief set the value of a simulated analog pin
+ * 
+ * @param pin pin name
+ * @param value 16 bit value
+ */
+void simulateAnalog(PinName pin, uint16_t value);
+
+/**
+ * @brief duty cycle of a simulated PWM pin
+ * 
+ * @param pin pin name
+ * @return float duty cycle 0.0...1.0
+ */
+float simulatedPwm(PinName pin);
+
+/**
+ * @brief callback for interrupts, a std::function on the host
+ * 
+ */
+template <typename F>
+class Callback;
+
+template <typename R, typename... Args>
+class Callback<R(Args...)> {
+
+	public:
+
+		Callback() {}
+		Callback(R (*function)(Args...)) : function(function) {}
+		template <typename T>
+		Callback(T* object, R (T::*method)(Args...)) : function([object, method](Args... args) { return (object->*method)(args...); }) {}
+		R operator()(Args... args) const { return function(args...); }
+		explicit operator bool() const { return (bool)function; }
+
+	private:
+
+		std::function<R(Args...)> function;
+
+	};
+
+template <typename T, typename R, typename... Args>
+Callback<R(Args...)> callback(T* object, R (T::*method)(Args...)) {
+	return Callback<R(Args...)>(object, method);
+	}
+
+template <typename R, typename... Args>
+Callback<R(Args...)> callback(R (*function)(Args...)) {
+	return Callback<R(Args...)>(function);
+	}
+
+/**
+ * @brief atomic operations with the names of mbed_atomic.h
+ * 
+ */
+inline int32_t core_util_atomic_load_s32(const volatile int32_t* value) {
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+	}
+
+inline void core_util_atomic_store_s32(volatile int32_t* value, int32_t desired) {
+	__atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+	}
+
+inline int32_t core_util_atomic_fetch_add_s32(volatile int32_t* value, int32_t arg) {
+	return __atomic_fetch_add(value, arg, __ATOMIC_SEQ_CST);
+	}
+
+inline int32_t core_util_atomic_fetch_sub_s32(volatile int32_t* value, int32_t arg) {
+	return __atomic_fetch_sub(value, arg, __ATOMIC_SEQ_CST);
+	}
+
+inline int32_t core_util_atomic_exchange_s32(volatile int32_t* value, int32_t desired) {
+	return __atomic_exchange_n(value, desired, __ATOMIC_SEQ_CST);
+	}
+
+/**
+ * @brief critical section, serialized with the simulated interrupts
+ * 
+ */
+void core_util_critical_section_enter();
+void core_util_critical_section_exit();
+
+inline bool core_util_atomic_load_bool(const volatile bool* value) {
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+	}
+
+inline void core_util_atomic_store_bool(volatile bool* value, bool desired) {
+	__atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+	}
+
+inline bool core_util_atomic_exchange_bool(volatile bool* value, bool desired) {
+	return __atomic_exchange_n(value, desired, __ATOMIC_SEQ_CST);
+	}
+
+inline uint8_t core_util_atomic_load_u8(const volatile uint8_t* value) {
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+	}
+
+inline void core_util_atomic_store_u8(volatile uint8_t* value, uint8_t desired) {
+	__atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+	}
+
+inline bool core_util_atomic_cas_u8(volatile uint8_t* value, uint8_t* expected, uint8_t desired) {
+	return __atomic_compare_exchange_n(value, expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+	}
+
+inline uint32_t core_util_atomic_load_u32(const volatile uint32_t* value) {
+	return __atomic_load_n(value, __ATOMIC_SEQ_CST);
+	}
+
+inline void core_util_atomic_store_u32(volatile uint32_t* value, uint32_t desired) {
+	__atomic_store_n(value, desired, __ATOMIC_SEQ_CST);
+	}
+
+inline uint32_t core_util_atomic_incr_u32(volatile uint32_t* value, uint32_t delta) {
+	return __atomic_add_fetch(value, delta, __ATOMIC_SEQ_CST);
+	}
+
+/**
+ * @brief simulated digital input
+ * 
+ */
+class DigitalIn {
+
+	public:
+
+		DigitalIn(PinName pin, PinMode mode = PullDefault);
+		int read();
+		operator int();
+
+	private:
+
+		PinName pin;
+
+	};
+
+/**
+ * @brief simulated interrupt input, the handlers are called by simulatePin() on a level change
+ * 
+ */
+class InterruptIn {
+
+	public:
+
+		InterruptIn(PinName pin);
+		InterruptIn(PinName pin, PinMode mode);
+		~InterruptIn();
+		int read();
+		operator int();
+		void mode(PinMode pull);
+		void rise(Callback<void()> func);
+		void fall(Callback<void()> func);
+		void enable_irq();
+		void disable_irq();
+
+	private:
+
+		PinName pin;
+		Callback<void()> riseHandler;
+		Callback<void()> fallHandler;
+		bool enabled;
+		InterruptIn* next;
+		friend void simulatePin(PinName pin, int value);
+
+	};
+
+/**
+ * @brief simulated analog input
+ * 
+ */
+class AnalogIn {
+
+	public:
+
+		AnalogIn(PinName pin);
+		uint16_t read_u16();
+		float read();
+
+	private:
+
+		PinName pin;
+
+	};
+
+/**
+ * @brief digital pin of the C HAL, can be used from interrupts
+ * 
+ */
+typedef struct {
+	PinName pin;
+	} gpio_t;
+
+void gpio_init_in_ex(gpio_t* obj, PinName pin, PinMode mode);
+void gpio_init_out_ex(gpio_t* obj, PinName pin, int value);
+int gpio_read(gpio_t* obj);
+void gpio_write(gpio_t* obj, int value);
+
+/**
+ * @brief analog input of the C HAL, can be read from interrupts
+ * 
+ */
+typedef struct {
+	PinName pin;
+	} analogin_t;
+
+void analogin_init(analogin_t* obj, PinName pin);
+uint16_t analogin_read_u16(analogin_t* obj);
+
+/**
+ * @brief PWM output of the C HAL, the duty cycle can be read with simulatedPwm()
+ * 
+ */
+typedef struct {
+	PinName pin;
+	} pwmout_t;
+
+void pwmout_init(pwmout_t* obj, PinName pin);
+void pwmout_free(pwmout_t* obj);
+void pwmout_period_us(pwmout_t* obj, int us);
+void pwmout_write(pwmout_t* obj, float percent);
+float pwmout_read(pwmout_t* obj);
+
+/**
+ * @brief periodic interrupt, the handler runs in its own thread on the host
+ * 
+ */
+class Ticker {
+
+	public:
+
+		Ticker();
+		~Ticker();
+		void attach(Callback<void()> func, std::chrono::microseconds period);
+		void detach();
+
+	private:
+
+		std::thread thread;
+		std::atomic<bool> running;
+
+	};
+
+typedef int osStatus;
+#define osOK 0
+
+typedef enum {
+	osPriorityLow = 8,
+	osPriorityBelowNormal = 16,
+	osPriorityNormal = 24,
+	osPriorityAboveNormal = 32,
+	osPriorityHigh = 40,
+	osPriorityRealtime = 48
+	} osPriority;
+
+/**
+ * @brief RTOS thread, a std::thread on the host, priority and stack size are ignored
+ * 
+ */
+class Thread {
+
+	public:
+
+		Thread(osPriority priority = osPriorityNormal, uint32_t stack_size = 0);
+		~Thread();
+		osStatus start(Callback<void()> task);
+		osStatus join();
+
+	private:
+
+		std::thread thread;
+
+	};
+
+/**
+ * @brief functions of the current thread
+ * 
+ */
+namespace ThisThread {
+	void sleep_for(std::chrono::milliseconds duration);
+	void yield();
+	}
+
+/**
+ * @brief counting semaphore
+ * 
+ */
+class Semaphore {
+
+	public:
+
+		Semaphore(int32_t count = 0);
+		osStatus release();
+		void acquire();
+		bool try_acquire();
+		bool try_acquire_for(std::chrono::milliseconds timeout);
+
+	private:
+
+		std::mutex lock;
+		std::condition_variable signal;
+		int32_t count;
+
+	};
+
+/**
+ * @brief recursive mutex like the RTOS mutex
+ * 
+ */
+class Mutex {
+
+	public:
+
+		void lock();
+		void unlock();
+		bool trylock();
+
+	private:
+
+		std::recursive_mutex mutex;
+
+	};
+
+/**
+ * @brief lock for the lifetime of the object
+ * 
+ */
+template <typename Lockable>
+class ScopedLock {
+
+	public:
+
+		ScopedLock(Lockable& lockable) : lockable(lockable) { lockable.lock(); }
+		~ScopedLock() { lockable.unlock(); }
+		ScopedLock(const ScopedLock&) = delete;
+		ScopedLock& operator=(const ScopedLock&) = delete;
+
+	private:
+
+		Lockable& lockable;
+
+	};
+
+/**
+ * @brief IPv4 socket address
+ * 
+ */
+class SocketAddress {
+
+	public:
+
+		SocketAddress();
+		SocketAddress(const void* bytes, nsapi_version_t version, uint16_t port = 0);
+		SocketAddress(const char* address, uint16_t port = 0);
+		void set_ip_bytes(const void* bytes, nsapi_version_t version);
+		void set_port(uint16_t port);
+		const void* get_ip_bytes() const;
+		uint16_t get_port() const;
+		bool operator==(const SocketAddress& address) const;
+		bool operator!=(const SocketAddress& address) const;
+
+	private:
+
+		uint8_t ip[4];
+		uint16_t port;
+
+	};
+
+/**
+ * @brief host network, the routing is done by the operating system
+ * 
+ */
+class NetworkInterface {
+
+	public:
+
+		nsapi_error_t connect();
+		nsapi_error_t disconnect();
+
+	};
+
+class EthernetInterface : public NetworkInterface {
+
+	public:
+
+		nsapi_error_t set_network(const SocketAddress& ip, const SocketAddress& netmask, const SocketAddress& gateway);
+
+	};
+
+/**
+ * @brief POSIX socket base
+ * 
+ */
+class Socket {
+
+	public:
+
+		Socket();
+		~Socket();
+		nsapi_error_t close();
+		void set_blocking(bool blocking);
+		void set_timeout(int timeout);
+
+	protected:
+
+		int fd;
+		bool blocking;
+		nsapi_error_t open(int type);
+		void configure();
+
+	};
+
+class UDPSocket : public Socket {
+
+	public:
+
+		nsapi_error_t open(NetworkInterface* interface);
+		nsapi_error_t bind(uint16_t port);
+		nsapi_size_or_error_t sendto(const SocketAddress& address, const void* data, nsapi_size_t size);
+		nsapi_size_or_error_t recvfrom(SocketAddress* address, void* data, nsapi_size_t size);
+
+	};
+
+class TCPSocket : public Socket {
+
+	public:
+
+		nsapi_error_t open(NetworkInterface* interface);
+		nsapi_error_t connect(const SocketAddress& address);
+		nsapi_size_or_error_t send(const void* data, nsapi_size_t size);
+		nsapi_size_or_error_t recv(void* data, nsapi_size_t size);
+
+	};
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef CHECK_H
+#define CHECK_H
+
+#include <stdio.h>
+
+/*
+Minimal checks for the host tests, a failed check is printed and the test
+returns 1 with CHECK_RESULT().
+*/
+
+static int checkFailures = 0;
+
+#define CHECK(condition) do { \
+	if (!(condition)) { \
+		printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+		checkFailures++; \
+		} \
+	} while (0)
+
+#define CHECK_RESULT() (checkFailures ? (printf("%d checks failed\n", checkFailures), 1) : 0)
+
+#endif
@@ -0,0 +1,55 @@
+#include "gma3.h"
+#include "check.h"
+
+#define LOCKOUT_MS 5
+
+static void settle() {
+	ThisThread::sleep_for(std::chrono::milliseconds(LOCKOUT_MS + 1));
+	}
+
+int main() {
+	bool level;
+	uint32_t time;
+	simulatePin(D6, 1);
+	Debouncer button(D6, LOCKOUT_MS);
+	CHECK(button.read());
+	CHECK(!button.event(level, time));
+	settle();
+
+	// the first edge counts, the bounces within the lockout are ignored
+	uint32_t start = halMicros();
+	simulatePin(D6, 0);
+	simulatePin(D6, 1);
+	simulatePin(D6, 0);
+	CHECK(button.event(level, time) && !level);
+	CHECK(time - start < LOCKOUT_MS * 1000);
+	CHECK(!button.event(level, time));
+	CHECK(button.bounces() == 2);
+	CHECK(button.bounces() == 0);
+	CHECK(!button.read());
+	settle();
+	CHECK(!button.event(level, time));
+
+	// a release which bounces back, the pin settles at the other level within the lockout
+	simulatePin(D6, 1);
+	simulatePin(D6, 0);
+	CHECK(button.event(level, time) && level);
+	CHECK(!button.event(level, time)); // still locked out
+	settle();
+	CHECK(button.event(level, time) && !level);
+	CHECK(!button.read());
+	CHECK(button.bounces() == 1);
+
+	// clean edges after the lockout
+	settle();
+	simulatePin(D6, 1);
+	settle();
+	simulatePin(D6, 0);
+	CHECK(button.event(level, time) && level);
+	uint32_t release = time;
+	CHECK(button.event(level, time) && !level);
+	CHECK(time - release >= LOCKOUT_MS * 1000);
+	CHECK(button.bounces() == 0);
+
+	return CHECK_RESULT();
+	}
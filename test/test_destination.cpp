@@ -0,0 +1,80 @@
+#include "gma3.h"
+#include "check.h"
+
+#define CONSOLE_PORT 48401
+#define BACKUP_PORT  48402
+#define LOGGER_PORT  48403
+#define TCP_PORT     48410 // no listener, messages are queued
+
+// a UDP receiver on localhost
+static void listen(UDPSocket& socket, uint16_t port) {
+	socket.open(nullptr);
+	socket.bind(port);
+	socket.set_blocking(false);
+	}
+
+// check for a message within 20ms
+static bool received(UDPSocket& socket) {
+	char osc[OSC_MESSAGE_SIZE];
+	for (uint8_t i = 0; i < 20; i++) {
+		if (socket.recvfrom(nullptr, osc, sizeof(osc)) > 0) return true;
+		ThisThread::sleep_for(std::chrono::milliseconds(1));
+		}
+	return false;
+	}
+
+// move the fader, one update after the update rate
+static void move(Fader& fader, uint16_t position) {
+	simulateAnalog(A1, position);
+	ThisThread::sleep_for(std::chrono::milliseconds(FADER_UPDATE_RATE_MS + 1));
+	fader.update();
+	}
+
+int main() {
+	uint8_t localhost[] = {127, 0, 0, 1};
+	UDPSocket console, backup, logger;
+	listen(console, CONSOLE_PORT);
+	listen(backup, BACKUP_PORT);
+	listen(logger, LOGGER_PORT);
+	interfaceUDP(localhost, CONSOLE_PORT);
+	int8_t backupIndex = destination(localhost, BACKUP_PORT);
+	int8_t loggerIndex = destination(localhost, LOGGER_PORT, UDP, 1, 1); // one message per second
+	CHECK((backupIndex >= 0) && (loggerIndex >= 0) && (backupIndex != loggerIndex));
+
+	// every destination gets a copy, the logger only within its rate
+	Fader fader(A1, 1, 201);
+	move(fader, 0);
+	CHECK(received(console) && received(backup) && received(logger));
+	move(fader, 40000);
+	CHECK(received(console) && received(backup) && !received(logger));
+	CHECK(destinationDropped(loggerIndex) == 1);
+	CHECK(destinationDropped(backupIndex) == 0);
+
+	// a route selects the targets
+	fader.route(TARGET_CONSOLE | (1 << (backupIndex + 1)));
+	move(fader, 0);
+	CHECK(received(console) && received(backup) && !received(logger));
+	CHECK(destinationDropped(loggerIndex) == 1);
+	fader.route(1 << (backupIndex + 1));
+	move(fader, 40000);
+	CHECK(!received(console) && received(backup));
+
+	// a removed destination gets nothing
+	removeDestination(backupIndex);
+	fader.route(TARGET_ALL);
+	move(fader, 0);
+	CHECK(received(console) && !received(backup));
+
+	// the TCP connection of a removed destination is free for the next one
+	fader.route(TARGET_CONSOLE);
+	for (uint8_t i = 0; i < 2 * TCP_CONNECTIONS; i++) {
+		int8_t index = destination(localhost, TCP_PORT + i, TCP);
+		fader.route(1 << (index + 1));
+		uint32_t sends = fader.stats().sends;
+		move(fader, (i & 1) ? 0 : 40000);
+		CHECK(fader.stats().sends == sends + 1);
+		removeDestination(index);
+		}
+
+	return CHECK_RESULT();
+	}
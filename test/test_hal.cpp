@@ -0,0 +1,42 @@
+#include "gma3.h"
+#include "check.h"
+
+static int edges = 0;
+
+static void edge() {
+	edges++;
+	}
+
+int main() {
+	// digital pins and interrupts
+	simulatePin(D2, 1);
+	DigitalIn input(D2);
+	CHECK(input.read() == 1);
+	InterruptIn interrupt(D2);
+	interrupt.fall(callback(edge));
+	simulatePin(D2, 0);
+	simulatePin(D2, 0); // no edge
+	CHECK(edges == 1);
+	CHECK(input.read() == 0);
+
+	// HAL pins
+	gpio_t out;
+	gpio_init_out_ex(&out, D3, 1);
+	CHECK(gpio_read(&out) == 1);
+	analogin_t adc;
+	analogin_init(&adc, A1);
+	simulateAnalog(A1, 12345);
+	CHECK(analogin_read_u16(&adc) == 12345);
+	pwmout_t pwm;
+	pwmout_init(&pwm, D4);
+	pwmout_write(&pwm, 1.5f);
+	CHECK(simulatedPwm(D4) == 1.0f);
+
+	// clocks
+	uint32_t start = halMicros();
+	ThisThread::sleep_for(std::chrono::milliseconds(2));
+	CHECK(halMicros() - start >= 2000);
+	CHECK(halCycleFrequency() == 1000000000);
+
+	return CHECK_RESULT();
+	}
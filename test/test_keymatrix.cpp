@@ -0,0 +1,30 @@
+#include "gma3.h"
+#include "check.h"
+
+int main() {
+	const PinName rows[] = {D2, D3};
+	const PinName columns[] = {D4, D5};
+
+	// a matrix without rows or columns has no keys and is never scanned
+	KeyMatrix noRows(rows, 0, columns, 2, 1, 101);
+	KeyMatrix noColumns(rows, 2, columns, 0, 1, 101);
+	CHECK(noRows.count() == 0);
+	CHECK(noColumns.count() == 0);
+	noRows.begin(1000);
+	noColumns.begin(1000);
+	noRows.scan();
+	noColumns.scan();
+	CHECK(!noRows.pressed(0));
+	noRows.end();
+	noColumns.end();
+
+	// a pressed key is taken after two agreeing scans
+	simulatePin(D4, 1);
+	simulatePin(D5, 0);
+	KeyMatrix matrix(rows, 2, columns, 2, 1, 101);
+	CHECK(matrix.count() == 4);
+	for (uint8_t i = 0; i < 4; i++) matrix.scan();
+	CHECK(!matrix.pressed(0) && matrix.pressed(1) && matrix.pressed(3));
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,75 @@
+#include "gma3.h"
+#include "check.h"
+
+#define CONSOLE_PORT 48501
+#define DEVICE_PORT  48502
+
+// a UDP receiver on localhost
+static void listen(UDPSocket& socket, uint16_t port) {
+	socket.open(nullptr);
+	socket.bind(port);
+	socket.set_blocking(false);
+	}
+
+// number of messages within 20ms
+static uint8_t received(UDPSocket& socket) {
+	char osc[OSC_MESSAGE_SIZE];
+	uint8_t count = 0;
+	for (uint8_t i = 0; i < 20; i++) {
+		while (socket.recvfrom(nullptr, osc, sizeof(osc)) > 0) count++;
+		ThisThread::sleep_for(std::chrono::milliseconds(1));
+		}
+	return count;
+	}
+
+// set the pin after the lockout and update the button
+static void press(OscButton& button, PinName pin, int level) {
+	ThisThread::sleep_for(std::chrono::milliseconds(DEBOUNCE_LOCKOUT_MS + 1));
+	simulatePin(pin, level);
+	button.update();
+	}
+
+int main() {
+	uint8_t localhost[] = {127, 0, 0, 1};
+	UDPSocket console, device;
+	listen(console, CONSOLE_PORT);
+	listen(device, DEVICE_PORT);
+	interfaceUDP(localhost, CONSOLE_PORT);
+
+	// press and release go to the address of the button only
+	simulatePin(D2, 1);
+	simulatePin(D3, 1);
+	OscButton* first = new OscButton(D2, "/first", (int32_t)1, localhost, DEVICE_PORT);
+	press(*first, D2, 0);
+	press(*first, D2, 1);
+	CHECK(received(device) == 2);
+	CHECK(received(console) == 0);
+	CHECK(first->stats().sends == 2);
+
+	// route() adds the console
+	first->route(TARGET_CONSOLE);
+	press(*first, D2, 0);
+	CHECK(received(device) == 1);
+	CHECK(received(console) == 1);
+
+	// a second button with the same address shares the destination entry
+	OscButton* second = new OscButton(D3, "/second", localhost, DEVICE_PORT);
+	press(*second, D3, 0);
+	CHECK(received(device) == 1);
+	uint8_t other[] = {127, 0, 0, 2};
+	int8_t taken[DESTINATIONS];
+	uint8_t count = 0;
+	while ((count < DESTINATIONS) && ((taken[count] = destination(other, DEVICE_PORT)) >= 0)) count++;
+	CHECK(count == DESTINATIONS - 1);
+	for (uint8_t i = 0; i < count; i++) removeDestination(taken[i]);
+
+	// the entry is free after the last button is gone
+	delete first;
+	delete second;
+	count = 0;
+	while ((count < DESTINATIONS) && ((taken[count] = destination(other, DEVICE_PORT)) >= 0)) count++;
+	CHECK(count == DESTINATIONS);
+	for (uint8_t i = 0; i < count; i++) removeDestination(taken[i]);
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,115 @@
+#include "gma3.h"
+#include "check.h"
+#include <string.h>
+
+#define TEST_PORT 48201
+
+UDPSocket console; // stands in for the console on localhost
+
+// address of the next message the console gets
+static bool receive(char* address, uint16_t size) {
+	char osc[OSC_MESSAGE_SIZE];
+	for (uint8_t i = 0; i < 100; i++) {
+		nsapi_size_or_error_t length = console.recvfrom(nullptr, osc, sizeof(osc));
+		if (length > 0) {
+			OscReader reader;
+			if (!reader.parse(osc, length)) return false;
+			snprintf(address, size, "%s", reader.address());
+			return true;
+			}
+		ThisThread::sleep_for(std::chrono::milliseconds(1));
+		}
+	return false;
+	}
+
+// one update after the update rate of the fader
+static void update(Fader& fader) {
+	ThisThread::sleep_for(std::chrono::milliseconds(FADER_UPDATE_RATE_MS + 1));
+	fader.update();
+	}
+
+int main() {
+	char address[OSC_PATTERN_SIZE];
+	uint8_t localhost[] = {127, 0, 0, 1};
+	console.open(nullptr);
+	console.bind(TEST_PORT);
+	console.set_blocking(false);
+	interfaceUDP(localhost, TEST_PORT);
+
+	simulateAnalog(A0, 0);
+	Fader fader(A0, 1, 201);
+	{
+		PageBank bank(2, 3);
+		CHECK(bank.add(fader));
+		CHECK(bank.selected() == 2);
+		update(fader); // the position is sent once at the begin
+		CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Page2/Fader201") == 0));
+		CHECK(bank.select(4));
+		update(fader);
+		CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Page4/Fader201") == 0));
+		CHECK(!bank.select(5));
+	}
+
+	// without the bank the fader is back on its own page
+	simulateAnalog(A0, 40000);
+	update(fader);
+	CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Page1/Fader201") == 0));
+
+	// a name change while the bank is selected is rendered into all its packets
+	{
+		PageBank bank(7, 1);
+		CHECK(bank.add(fader));
+		fader.resend();
+		update(fader);
+		CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Page7/Fader201") == 0));
+		page("Seite");
+		fader.resend();
+		update(fader);
+		CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Seite7/Fader201") == 0));
+	}
+	simulateAnalog(A0, 0);
+	update(fader);
+	CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Seite1/Fader201") == 0));
+
+	// a key held while its bank is destroyed is released on the page of the press
+	simulatePin(D7, 1);
+	Key key(D7, 1, 201);
+	PageBank* keyBank = new PageBank(5, 2);
+	CHECK(keyBank->add(key));
+	ThisThread::sleep_for(std::chrono::milliseconds(DEBOUNCE_LOCKOUT_MS + 1));
+	simulatePin(D7, 0);
+	key.update();
+	CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Seite5/Key201") == 0));
+	delete keyBank;
+	PageBank* reused = new PageBank(9, 2); // usually gets the memory of the destroyed bank
+	ThisThread::sleep_for(std::chrono::milliseconds(DEBOUNCE_LOCKOUT_MS + 1));
+	simulatePin(D7, 1);
+	key.update();
+	CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Seite5/Key201") == 0));
+	ThisThread::sleep_for(std::chrono::milliseconds(DEBOUNCE_LOCKOUT_MS + 1));
+	simulatePin(D7, 0);
+	key.update();
+	CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Seite1/Key201") == 0));
+	delete reused;
+
+	// a truncated address isn't sent, neither on the own page nor from a bank
+	prefix(string(OSC_PATTERN_SIZE, 'x'));
+	uint32_t failures = fader.stats().failures;
+	fader.resend();
+	update(fader);
+	CHECK(!receive(address, sizeof(address)));
+	CHECK(fader.stats().failures == failures + 1);
+	{
+		PageBank bank(3, 1);
+		CHECK(bank.add(fader));
+		fader.resend();
+		update(fader);
+		CHECK(!receive(address, sizeof(address)));
+	}
+	prefix("");
+	fader.resend();
+	update(fader);
+	CHECK(receive(address, sizeof(address)) && (strcmp(address, "/Seite1/Fader201") == 0));
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,128 @@
+#include "gma3.h"
+#include "check.h"
+#include <string.h>
+
+static uint16_t fader(char* osc, float value) {
+	return message(osc, OSC_MESSAGE_SIZE, "/f", value);
+	}
+
+static uint16_t key(char* osc, int32_t number) {
+	char pattern[16];
+	snprintf(pattern, sizeof(pattern), "/k%d", (int)number);
+	return message(osc, OSC_MESSAGE_SIZE, pattern, (int32_t)1);
+	}
+
+// pops all messages, counts them and gives the last value of an address
+static uint16_t drain(OscQueue& queue, const char* address, OscReader& last, char* copy) {
+	uint16_t count = 0;
+	uint16_t length;
+	protocol_t protocol;
+	uint8_t targets;
+	const char* osc;
+	while ((osc = queue.front(length, protocol, targets)) != nullptr) {
+		OscReader reader;
+		if (reader.parse(osc, length) && (strcmp(reader.address(), address) == 0)) {
+			memcpy(copy, osc, length);
+			last.parse(copy, length);
+			}
+		queue.pop();
+		count++;
+		}
+	return count;
+	}
+
+int main() {
+	char osc[OSC_MESSAGE_SIZE];
+	char copy[OSC_MESSAGE_SIZE];
+	OscReader last;
+
+	// KEEP queues every message until the ring is full
+	{
+		static OscQueue queue;
+		for (int32_t i = 0; i < QUEUE_SLOTS; i++) {
+			CHECK(queue.push(osc, key(osc, i), UDP));
+			}
+		CHECK(!queue.push(osc, key(osc, 99), UDP));
+		CHECK((queue.count() == QUEUE_SLOTS) && (queue.dropped() == 1));
+		CHECK(drain(queue, "/k0", last, copy) == QUEUE_SLOTS);
+	}
+
+	// LATEST replaces the queued value of the same address
+	{
+		static OscQueue queue;
+		CHECK(queue.push(osc, fader(osc, 10.0f), UDP, LATEST));
+		CHECK(queue.push(osc, key(osc, 1), UDP));
+		CHECK(queue.push(osc, fader(osc, 20.0f), UDP, LATEST));
+		CHECK(queue.replaced() == 1);
+		CHECK(drain(queue, "/f", last, copy) == 2);
+		CHECK(last.getFloat(0) == 20.0f);
+	}
+
+	// LATEST with a full ring replaces the value in place, nothing is lost
+	{
+		static OscQueue queue;
+		CHECK(queue.push(osc, fader(osc, 10.0f), UDP, LATEST));
+		for (int32_t i = 1; i < QUEUE_SLOTS; i++) {
+			CHECK(queue.push(osc, key(osc, i), UDP));
+			}
+		CHECK(queue.push(osc, fader(osc, 30.0f), UDP, LATEST));
+		CHECK((queue.dropped() == 0) && (queue.replaced() == 1) && (queue.count() == QUEUE_SLOTS));
+		CHECK(drain(queue, "/f", last, copy) == QUEUE_SLOTS);
+		CHECK((last.count() == 1) && (last.getFloat(0) == 30.0f));
+	}
+
+	// a full ring can't replace a message the consumer has taken already
+	{
+		static OscQueue queue;
+		CHECK(queue.push(osc, fader(osc, 10.0f), UDP, LATEST));
+		for (int32_t i = 1; i < QUEUE_SLOTS; i++) {
+			CHECK(queue.push(osc, key(osc, i), UDP));
+			}
+		uint16_t length;
+		protocol_t protocol;
+		uint8_t targets;
+		CHECK(queue.front(length, protocol, targets) != nullptr);
+		CHECK(!queue.push(osc, fader(osc, 40.0f), UDP, LATEST));
+		CHECK(queue.dropped() == 1);
+		queue.pop();
+		CHECK(queue.push(osc, fader(osc, 40.0f), UDP, LATEST));
+		CHECK(drain(queue, "/f", last, copy) == QUEUE_SLOTS);
+		CHECK(last.getFloat(0) == 40.0f);
+	}
+
+	// SUM adds the deltas of the same address
+	{
+		static OscQueue queue;
+		CHECK(queue.push(osc, message(osc, OSC_MESSAGE_SIZE, "/e", (int32_t)3), UDP, SUM));
+		CHECK(queue.push(osc, key(osc, 1), UDP));
+		CHECK(queue.push(osc, message(osc, OSC_MESSAGE_SIZE, "/e", (int32_t)-1), UDP, SUM));
+		CHECK(queue.replaced() == 1);
+		CHECK(drain(queue, "/e", last, copy) == 2);
+		CHECK(last.getInt(0) == 2);
+	}
+
+	// SUM with a full ring adds the deltas in place, nothing is lost
+	{
+		static OscQueue queue;
+		CHECK(queue.push(osc, message(osc, OSC_MESSAGE_SIZE, "/e", (int32_t)5), UDP, SUM));
+		for (int32_t i = 1; i < QUEUE_SLOTS; i++) {
+			CHECK(queue.push(osc, key(osc, i), UDP));
+			}
+		CHECK(queue.push(osc, message(osc, OSC_MESSAGE_SIZE, "/e", (int32_t)7), UDP, SUM));
+		CHECK(queue.push(osc, message(osc, OSC_MESSAGE_SIZE, "/e", (int32_t)-2), UDP, SUM));
+		CHECK((queue.dropped() == 0) && (queue.replaced() == 2));
+		CHECK(drain(queue, "/e", last, copy) == QUEUE_SLOTS);
+		CHECK(last.getInt(0) == 10);
+	}
+
+	// messages to other targets or protocols are not coalesced
+	{
+		static OscQueue queue;
+		CHECK(queue.push(osc, fader(osc, 10.0f), UDP, LATEST, TARGET_CONSOLE));
+		CHECK(queue.push(osc, fader(osc, 20.0f), UDP, LATEST, TARGET_ALL));
+		CHECK(queue.push(osc, fader(osc, 30.0f), TCP11, LATEST, TARGET_ALL));
+		CHECK((queue.replaced() == 0) && (queue.count() == 3));
+	}
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,82 @@
+#include "gma3.h"
+#include "check.h"
+#include <string.h>
+
+#define CONSOLE_PORT 48601
+#define LOCAL_PORT   48602
+
+// count the received messages
+static void handler(OscReader& msg, void* context) {
+	(void)msg;
+	(*(uint8_t*)context)++;
+	}
+
+int main() {
+	char osc[128];
+	OscReader reader;
+
+	// arguments of all types
+	uint16_t length = oscMessage(osc, sizeof(osc), UDP, "/m", (int32_t)-7, 2.5f, "text", (int64_t)1 << 40, 0.25, OscBlob{"\x01\x02\x03", 3});
+	CHECK(reader.parse(osc, length));
+	CHECK(strcmp(reader.address(), "/m") == 0);
+	CHECK(strcmp(reader.tags(), "ifshdb") == 0);
+	CHECK(reader.count() == 6);
+	CHECK(reader.getInt(0) == -7);
+	CHECK(reader.getFloat(1) == 2.5f);
+	CHECK(reader.getInt(1) == 3); // rounded
+	CHECK(strcmp(reader.getString(2), "text") == 0);
+	CHECK(reader.getInt64(3) == (int64_t)1 << 40);
+	CHECK(reader.getDouble(4) == 0.25);
+	uint16_t blobLength;
+	const char* blob = reader.getBlob(5, blobLength);
+	CHECK((blobLength == 3) && (memcmp(blob, "\x01\x02\x03", 3) == 0));
+	CHECK(reader.type(6) == '\0');
+
+	// flags and messages without type tags
+	length = message(osc, sizeof(osc), "/t", T);
+	CHECK(reader.parse(osc, length) && reader.getBool(0));
+	CHECK(reader.parse("/go\0", 4) && (reader.count() == 0));
+
+	// truncated and malformed messages are rejected
+	length = message(osc, sizeof(osc), "/f", 1.0f);
+	CHECK(!reader.parse(osc, length - 4));
+	CHECK(!reader.parse("go\0\0", 4));
+	CHECK(!reader.parse("/a\0\0,x\0\0", 8)); // unknown tag
+	CHECK(!reader.parse("/a\0\0,s\0\0abcd", 12)); // string without terminator
+
+	// blob sizes larger than the message, also where the padding wraps around
+	const uint32_t sizes[] = {5, 0x7FFFFFFF, 0xFFFFFFFC, 0xFFFFFFFD, 0xFFFFFFFE, 0xFFFFFFFF};
+	for (uint32_t size : sizes) {
+		char bad[16] = "/b\0\0,b\0\0";
+		oscStore32(bad + 8, size);
+		memcpy(bad + 12, "\x01\x02\x03\x04", 4);
+		CHECK(!reader.parse(bad, sizeof(bad)));
+		CHECK(reader.getBlob(0, blobLength) == nullptr);
+		}
+	char good[16] = "/b\0\0,b\0\0";
+	oscStore32(good + 8, 4);
+	CHECK(reader.parse(good, sizeof(good)) && (reader.getBlob(0, blobLength) != nullptr) && (blobLength == 4));
+
+	// messages from the console arrive on the local port, sending uses its own socket
+	uint8_t localhost[] = {127, 0, 0, 1};
+	UDPSocket console;
+	console.open(nullptr);
+	console.bind(CONSOLE_PORT);
+	console.set_blocking(false);
+	interfaceUDP(localhost, CONSOLE_PORT, LOCAL_PORT);
+	uint8_t handled = 0;
+	CHECK(oscHandler("/feedback", handler, &handled));
+	receiveUDP(); // returns without messages
+	length = message(osc, sizeof(osc), "/feedback", 1.0f);
+	console.sendto(SocketAddress(localhost, NSAPI_IPv4, LOCAL_PORT), osc, length);
+	for (uint8_t i = 0; (i < 20) && (handled == 0); i++) {
+		ThisThread::sleep_for(std::chrono::milliseconds(1));
+		receiveUDP();
+		}
+	CHECK(handled == 1);
+	CHECK(sendUDP(osc, length));
+	ThisThread::sleep_for(std::chrono::milliseconds(5));
+	CHECK(console.recvfrom(nullptr, osc, sizeof(osc)) == length);
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,65 @@
+#include "gma3.h"
+#include "check.h"
+
+// counts its updates
+class Counter : public Control {
+
+	public:
+
+		Counter(uint16_t period) : Control(period), updates(0) {}
+
+		void update() {
+			updates++;
+			}
+
+		uint32_t updates;
+
+	};
+
+// calls updateControls() for a time
+static void run(uint32_t time) {
+	uint32_t start = halMicros();
+	while (halMicros() - start < time * 1000) {
+		updateControls();
+		ThisThread::sleep_for(std::chrono::milliseconds(1));
+		}
+	}
+
+int main() {
+	Counter fast(5);
+	Counter slow(50);
+	Counter* removed = new Counter(5);
+
+	// new controls are due with the first pass
+	updateControls();
+	CHECK((fast.updates == 1) && (slow.updates == 1) && (removed->updates == 1));
+
+	// each control is updated once per period, late passes are not made up
+	run(200);
+	CHECK((fast.updates >= 20) && (fast.updates <= 42));
+	CHECK((slow.updates >= 3) && (slow.updates <= 6));
+
+	// a destroyed control leaves the wheel
+	delete removed;
+	uint32_t updates = fast.updates;
+	run(50);
+	CHECK(fast.updates > updates);
+
+	// a period longer than the wheel
+	Counter rare(SCHEDULER_SLOTS * SCHEDULER_TICK_US / 1000 * 2);
+	run(10);
+	CHECK(rare.updates == 1);
+	run(SCHEDULER_SLOTS * SCHEDULER_TICK_US / 1000);
+	CHECK(rare.updates == 1);
+	run(SCHEDULER_SLOTS * SCHEDULER_TICK_US / 1000 + 20);
+	CHECK(rare.updates == 2);
+
+	// a control which gets slower
+	fast.rate(100);
+	run(20); // the pending period ends
+	updates = fast.updates;
+	run(150);
+	CHECK((fast.updates - updates >= 1) && (fast.updates - updates <= 2));
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,102 @@
+#include "gma3.h"
+#include "check.h"
+#include <string.h>
+
+int main() {
+	// END and ESC in the data are escaped
+	const char raw[] = {'a', END, 'b', ESC, 'c'};
+	char framed[32];
+	uint16_t length = slipEncode(raw, sizeof(raw), framed, sizeof(framed));
+	const char expected[] = {END, 'a', ESC, ESC_END, 'b', ESC, ESC_ESC, 'c', END};
+	CHECK((length == sizeof(expected)) && (memcmp(framed, expected, length) == 0));
+	CHECK(slipEncode(raw, sizeof(raw), framed, sizeof(expected) - 1) == 0);
+
+	// decoding gives back the data, in place too
+	char decoded[32];
+	length = slipDecode(framed, sizeof(expected), decoded, sizeof(decoded));
+	CHECK((length == sizeof(raw)) && (memcmp(decoded, raw, length) == 0));
+	char inPlace[32];
+	memcpy(inPlace, expected, sizeof(expected));
+	length = slipDecode(inPlace, sizeof(expected), inPlace, sizeof(inPlace));
+	CHECK((length == sizeof(raw)) && (memcmp(inPlace, raw, length) == 0));
+
+	// the in place buffer encoding of the string API
+	string text(raw, sizeof(raw));
+	slipEncode(text);
+	CHECK((text.length() == sizeof(expected)) && (memcmp(text.data(), expected, sizeof(expected)) == 0));
+	slipDecode(text);
+	CHECK((text.length() == sizeof(raw)) && (memcmp(text.data(), raw, sizeof(raw)) == 0));
+
+	// the string API has no 64 KB limit
+	string large(70000, 'a');
+	for (size_t i = 0; i < large.length(); i += 2) {
+		large[i] = (i % 4) ? ESC : END;
+		}
+	string original = large;
+	slipEncode(large);
+	CHECK(large.length() == original.length() + original.length() / 2 + 2);
+	CHECK((large[0] == END) && (large[large.length() - 1] == END));
+	slipDecode(large);
+	CHECK(large == original);
+
+	// a stream of two frames fed byte by byte
+	char stream[64];
+	uint16_t streamLength = slipEncode(raw, sizeof(raw), stream, sizeof(stream));
+	streamLength += slipEncode("xyz", 3, stream + streamLength, sizeof(stream) - streamLength);
+	char frame[16];
+	SlipDecoder slip(frame, sizeof(frame));
+	uint8_t frames = 0;
+	for (uint16_t i = 0; i < streamLength; i++) {
+		CHECK(slip.decode(stream + i, 1) == 1);
+		if (!slip.available()) continue;
+		frames++;
+		if (frames == 1) CHECK((slip.length() == sizeof(raw)) && (memcmp(slip.data(), raw, sizeof(raw)) == 0));
+		if (frames == 2) CHECK((slip.length() == 3) && (memcmp(slip.data(), "xyz", 3) == 0));
+		}
+	CHECK(frames == 2);
+
+	// a chunk stops after each frame
+	uint16_t consumed = slip.decode(stream, streamLength);
+	CHECK(slip.available() && (consumed == sizeof(expected)));
+	consumed += slip.decode(stream + consumed, streamLength - consumed);
+	CHECK(slip.available() && (slip.length() == 3) && (consumed == streamLength));
+
+	// frames longer than the buffer are dropped, the next one is decoded
+	char small[4];
+	SlipDecoder shortSlip(small, sizeof(small));
+	const char overflow[] = {END, '1', '2', '3', '4', '5', END, 'o', 'k', END};
+	consumed = shortSlip.decode(overflow, sizeof(overflow));
+	CHECK(shortSlip.available() && (shortSlip.length() == 2) && (memcmp(shortSlip.data(), "ok", 2) == 0));
+	CHECK(shortSlip.dropped() == 1);
+
+	// TCP10 length prefix
+	char prefixed[32];
+	memcpy(prefixed, "abcde", 5);
+	length = tcpEncode(prefixed, 5, sizeof(prefixed));
+	CHECK((length == 9) && (oscLoad32(prefixed) == 5) && (memcmp(prefixed + 4, "abcde", 5) == 0));
+	CHECK(tcpEncode(prefixed, 5, 8) == 0);
+
+	// length prefixed stream in odd chunks, with a frame too large for the buffer
+	char tcpStream[64];
+	uint16_t tcpLength = 0;
+	memcpy(tcpStream, "\0\0\0\x03" "abc" "\0\0\0\x08" "12345678" "\0\0\0\x02" "ok", 4 + 3 + 4 + 8 + 4 + 2);
+	tcpLength = 4 + 3 + 4 + 8 + 4 + 2;
+	char tcpFrame[4];
+	TcpDecoder tcp(tcpFrame, sizeof(tcpFrame));
+	frames = 0;
+	for (uint16_t i = 0; i < tcpLength; i += 3) {
+		uint16_t chunk = (tcpLength - i < 3) ? tcpLength - i : 3;
+		uint16_t used = 0;
+		while (used < chunk) {
+			used += tcp.decode(tcpStream + i + used, chunk - used);
+			if (!tcp.available()) continue;
+			frames++;
+			if (frames == 1) CHECK((tcp.length() == 3) && (memcmp(tcp.data(), "abc", 3) == 0));
+			if (frames == 2) CHECK((tcp.length() == 2) && (memcmp(tcp.data(), "ok", 2) == 0));
+			}
+		}
+	CHECK(frames == 2);
+	CHECK(tcp.dropped() == 1);
+
+	return CHECK_RESULT();
+	}
@@ -0,0 +1,120 @@
+#include "gma3.h"
+#include "check.h"
+#include <string.h>
+
+static bool equal(const char* data, uint16_t length, const char* expected, uint16_t expectedLength) {
+	return (length == expectedLength) && (memcmp(data, expected, length) == 0);
+	}
+
+int main() {
+	char osc[128];
+
+	// int32 argument, address and tags are padded to 4 bytes
+	uint16_t length = message(osc, sizeof(osc), "/gma3/Key1", (int32_t)1);
+	const char key[] = "/gma3/Key1\0\0,i\0\0\0\0\0\x01";
+	CHECK(equal(osc, length, key, sizeof(key) - 1));
+
+	// float argument in network byte order
+	length = message(osc, sizeof(osc), "/f", 1.0f);
+	const char fader[] = "/f\0\0,f\0\0\x3f\x80\0\0";
+	CHECK(equal(osc, length, fader, sizeof(fader) - 1));
+
+	// string argument with a full padding word
+	length = message(osc, sizeof(osc), "/cmd", "Go+");
+	const char command[] = "/cmd\0\0\0\0,s\0\0Go+\0";
+	CHECK(equal(osc, length, command, sizeof(command) - 1));
+
+	// flag and no argument
+	length = message(osc, sizeof(osc), "/t", T);
+	CHECK(equal(osc, length, "/t\0\0,T\0\0", 8));
+	length = message(osc, sizeof(osc), "/go");
+	CHECK(equal(osc, length, "/go\0,\0\0\0", 8));
+
+	// a buffer which is too small gives 0
+	CHECK(message(osc, 11, "/gma3/Key1", (int32_t)1) == 0);
+
+	// the string API encodes the same bytes
+	string text = "/gma3/Key1";
+	message(text, (int32_t)1);
+	CHECK(equal(text.data(), text.length(), key, sizeof(key) - 1));
+
+	// TCP10 prefixes the length
+	length = message(osc, sizeof(osc), "/f", 1.0f, TCP10);
+	CHECK(length == 16);
+	CHECK(oscLoad32(osc) == 12);
+	CHECK(memcmp(osc + 4, fader, 12) == 0);
+
+	// TCP11 is SLIP framed with END at both sides
+	length = message(osc, sizeof(osc), "/f", 1.0f, TCP11);
+	CHECK(length == 14);
+	CHECK((osc[0] == END) && (osc[13] == END));
+	CHECK(memcmp(osc + 1, fader, 12) == 0);
+
+	// arrays and blobs
+	const int32_t rgb[3] = {255, 128, 0};
+	length = message(osc, sizeof(osc), "/rgb", rgb, 3);
+	CHECK(length == 8 + 8 + 12);
+	CHECK(memcmp(osc + 8, ",iii\0\0\0\0", 8) == 0);
+	CHECK(oscLoad32(osc + 16) == 255 && oscLoad32(osc + 20) == 128 && oscLoad32(osc + 24) == 0);
+	length = message(osc, sizeof(osc), "/b", "\x01\x02\x03", (uint16_t)3);
+	const char blob[] = "/b\0\0,b\0\0\0\0\0\x03\x01\x02\x03\0";
+	CHECK(equal(osc, length, blob, sizeof(blob) - 1));
+
+	// a blob near 64 KB doesn't wrap the size, nothing is written behind the buffer
+	static char large[65535];
+	static char guarded[256];
+	const uint16_t blobLengths[] = {65532, 65533, 65535};
+	for (uint16_t blobLength : blobLengths) {
+		memset(guarded, 0x55, sizeof(guarded));
+		CHECK(message(guarded, 64, "/b", large, blobLength) == 0);
+		bool untouched = true;
+		for (uint16_t i = 64; i < sizeof(guarded); i++) {
+			if (guarded[i] != 0x55) untouched = false;
+			}
+		CHECK(untouched);
+		}
+
+	// an address or string argument near 64 KB fails too
+	static char longText[70001];
+	memset(longText, 'a', sizeof(longText) - 1);
+	const uint32_t longLengths[] = {65532, 65535, 65536, 70000};
+	for (uint32_t longLength : longLengths) {
+		longText[longLength] = '\0';
+		memset(guarded, 0x55, sizeof(guarded));
+		CHECK(message(guarded, 64, longText, (int32_t)1) == 0);
+		CHECK(message(guarded, 64, "/s", longText) == 0);
+		bool untouched = true;
+		for (uint16_t i = 64; i < sizeof(guarded); i++) {
+			if (guarded[i] != 0x55) untouched = false;
+			}
+		CHECK(untouched);
+		longText[longLength] = 'a';
+		}
+	OscWriter writer(osc, sizeof(osc));
+	writer.begin("/b", "b");
+	writer.addBlob(large, 65532);
+	CHECK(writer.overflow() && (writer.length() == 0));
+
+	// mixed arguments from the types
+	length = oscMessage(osc, sizeof(osc), UDP, "/m", (int32_t)-1, 2.0f, (int64_t)3, 4.0, "s");
+	CHECK(length == 4 + 8 + 4 + 4 + 8 + 8 + 4);
+	CHECK(memcmp(osc + 4, ",ifhds\0\0", 8) == 0);
+	CHECK(oscLoad32(osc + 12) == 0xFFFFFFFF);
+	CHECK(oscLoad32(osc + 20) == 0 && oscLoad32(osc + 24) == 3);
+
+	// a compile-time template encodes the same bytes as the runtime writer
+	static constexpr auto rgbTemplate = oscTemplate<float, float, float>("/light/rgb");
+	char fixed[rgbTemplate.size()];
+	uint16_t fixedLength = rgbTemplate.message(fixed, sizeof(fixed), 1.0f, 0.5f, 0.0f);
+	length = oscMessage(osc, sizeof(osc), UDP, "/light/rgb", 1.0f, 0.5f, 0.0f);
+	CHECK(equal(fixed, fixedLength, osc, length));
+	CHECK(rgbTemplate.message(fixed, sizeof(fixed) - 1, 1.0f, 0.5f, 0.0f) == 0);
+
+	// the cached packet only patches the argument
+	OscPacket packet;
+	CHECK(packet.build("/gma3/Key1"));
+	packet.set((int32_t)1);
+	CHECK(equal(packet.data(), packet.length(), key, sizeof(key) - 1));
+
+	return CHECK_RESULT();
+	}